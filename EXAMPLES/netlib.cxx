@@ -5,8 +5,11 @@
 #include <assert.h>
 #include <string.h>
 #include <string>
+#include <chrono>
 #include "libobjects.hxx"
 #include "vlogobjects.hxx"
+#include "netbind.hxx"
+#include "netstats.hxx"
 
 using namespace std;
 
@@ -132,5 +135,40 @@ int main(int argc,char **argv)
         display_group(g.second,indent);
         d.second->print();
     }
+    if (g.second && d.second) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        const NETLIB::Binding                  b(d.second,vector<const DLIB::Group*>(1,g.second));
+        const double                           t     = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        size_t                                 bound = 0,pins = 0;
+
+        for (unsigned i=0; i<b.get_inst_count(); ++i) {
+            for (unsigned p=0; b.get_cell(i) && p<b.get_port_count(i); ++p) {
+                pins += b.get_pin(i,p) != 0;
+            }
+            bound += b.get_cell(i) != 0;
+        }
+        printf("Bound %zu of %zu instances to %zu cells, %zu ports to pins in %.3f s\n",bound,b.get_inst_count(),b.get_cell_count(),pins,t);
+        for (size_t x=0; x<b.get_unbound_models().size(); ++x) {
+            printf("Unbound model %s\n",b.get_unbound_models()[x]);
+        }
+
+        const chrono::steady_clock::time_point rollup = chrono::steady_clock::now();
+        const NETLIB::HierarchyStats           s(d.second,&b);
+        const VLP::NameList                    tops  = d.second->find_top_modules();
+
+        printf("Rolled up the hierarchy in %.3f s\n",chrono::duration<double>(chrono::steady_clock::now() - rollup).count());
+        for (size_t x=0; x<tops.size(); ++x) {
+            const NETLIB::HierarchyStats::Stats *top = s.get_stats(d.second->get_module(tops[x]));
+
+            if (top) {
+                printf("Top module %s: %llu instances, %llu leaf instances of %zu models (%llu unbound), area %g, leakage %g, depth %u\n",
+                       tops[x],(unsigned long long) top->instances,(unsigned long long) top->leaf_instances,top->models.size(),
+                       (unsigned long long) top->unbound_instances,top->area,top->leakage,top->depth);
+            }
+        }
+        for (size_t x=0; x<s.get_recursive_modules().size(); ++x) {
+            printf("Recursive module %s\n",s.get_recursive_modules()[x]);
+        }
+    }
     return g.first && d.first ? 0 : 1;
 }
@@ -0,0 +1,122 @@
+// Netlist simulation benchmark
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "libobjects.hxx"
+#include "vlogobjects.hxx"
+#include "vlogflat.hxx"
+#include "netbind.hxx"
+#include "netsim.hxx"
+
+using namespace std;
+
+// Usage: netsimbench.exe [-p passes] [-w words] [-m top] library verilog
+//   Flattens the top module of the design, binds its instances to the cells
+//   of the library and simulates random patterns. Reports the patterns per
+//   second with 64 and 256 patterns per pass (or only with -w words) and
+//   the average toggle rate of the nets.
+
+static bool simulate(const VLP::FlatDesign *flat,const NETLIB::Binding *binding,const unsigned words,const unsigned passes)
+{
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    NETLIB::Simulator                      sim(flat,binding,words);
+    const double                           setup = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("    %u words: %zu gates, %u levels, %zu sources, %zu unbound instances, %zu loops cut (set up in %.3f s)\n",
+           sim.get_words(),sim.get_gate_count(),sim.get_level_count(),sim.get_sources().size(),
+           sim.get_unbound_count(),sim.get_loop_count(),setup);
+
+    // The first pass warms the caches and is not timed
+    sim.randomize(0);
+    sim.run();
+    sim.count_toggles();
+
+    const chrono::steady_clock::time_point go = chrono::steady_clock::now();
+
+    for (unsigned x=1; x<=passes; ++x) {
+        sim.randomize(x);
+        sim.run();
+    }
+    const double secs     = chrono::duration<double>(chrono::steady_clock::now() - go).count();
+    const double patterns = double(passes) * sim.get_patterns();
+    uint64_t     toggles  = 0;
+    size_t       nets     = 0;
+
+    for (unsigned n=VLP::FlatDesign::NET_FIRST; n<flat->get_net_count(); ++n) {
+        if (sim.get_driver(n) != NETLIB::Simulator::npos) {
+            toggles += sim.get_toggles(n);
+            ++nets;
+        }
+    }
+    printf("    %u words: %8.3f s %10.1f kpatterns/s %10.2f Mgates*patterns/s, toggle rate %.4f\n",
+           sim.get_words(),secs,patterns / secs / 1e3,patterns * sim.get_gate_count() / secs / 1e6,
+           (nets && sim.get_toggle_patterns()) ? double(toggles) / nets / sim.get_toggle_patterns() : 0.0);
+    return sim.get_gate_count() != 0;
+}
+
+int main(int argc,char **argv)
+{
+    unsigned    passes  = 100;
+    unsigned    words   = 0;
+    const char *top     = 0;
+    const char *libname = 0;
+    const char *vlgname = 0;
+
+    for (int x=1; x<argc; ++x) {
+        if (!strcmp(argv[x],"-p") && x+1 < argc) {
+            passes = atoi(argv[++x]);
+        } else if (!strcmp(argv[x],"-w") && x+1 < argc) {
+            words = atoi(argv[++x]);
+        } else if (!strcmp(argv[x],"-m") && x+1 < argc) {
+            top = argv[++x];
+        } else if (!libname) {
+            libname = argv[x];
+        } else {
+            vlgname = argv[x];
+        }
+    }
+    if (!libname || !vlgname) {
+        printf("Usage: %s [-p passes] [-w words] [-m top] library verilog\n",argv[0]);
+        return 1;
+    }
+    pair<bool,DLIB::Group*> g = DLIB::parse_lib_file(libname);
+    pair<bool,VLP::Design*> d = VLP::parse_vlog_file(vlgname);
+
+    if (!g.second || !d.second) {
+        printf("%s: could not read the library or the design\n",argv[0]);
+        return 1;
+    }
+    const VLP::NameList  tops = d.second->find_top_modules();
+    const VLP::Module   *m    = top ? d.second->get_module(top) : (tops.empty() ? 0 : d.second->get_module(tops[0]));
+
+    if (!m) {
+        printf("%s: no top module\n",vlgname);
+        return 1;
+    }
+    VLP::FlatDesign                       *flat  = d.second->flatten(m);
+
+    if (!flat) {
+        printf("%s: cannot flatten %s\n",vlgname,m->get_name());
+        return 1;
+    }
+    bool                                   isok  = g.first && d.first;
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    const NETLIB::Binding                  binding(d.second,vector<const DLIB::Group*>(1,g.second));
+    const double                           bind  = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%s: top %s, %zu leaf instances, %zu nets (bound in %.3f s)\n",vlgname,m->get_name(),flat->get_inst_count(),
+           flat->get_net_count(),bind);
+    if (words != 4) {
+        isok = simulate(flat,&binding,1,passes) && isok;
+    }
+    if (words != 1) {
+        isok = simulate(flat,&binding,4,passes) && isok;
+    }
+    delete flat;
+    delete d.second;
+    delete g.second;
+    return isok ? 0 : 1;
+}
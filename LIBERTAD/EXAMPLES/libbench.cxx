@@ -0,0 +1,483 @@
+// .LIB reader benchmark
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "libobjects.hxx"
+
+using namespace std;
+
+// Usage: libbench.exe [-n runs] [-c] [-l percent] [-t threads] [-u] [-k] [-q] [-f] [-e filter]... file
+//   Compares the parse throughput of stdio and memory mapped input.
+//   -c also times the load of the library from its binary cache, which is
+//   written first if it is not current.
+//   -l also times a lazy parse followed by the lookup of the given
+//   percentage of the cells, spread over the library.
+//   -t also times a parse of the library groups on the given number of
+//   threads, 0 for one per hardware thread.
+//   -u also times the decoding of the timing and power tables of the
+//   library, against get_text_as_vector(), and their interpolation.
+//   -k also times the parse with the hand written tokenizer.
+//   -q also times the lookup of every cell by name and of its area,
+//   against a scan of the subgroups and attributes.
+//   -f also times the compilation of the pin functions of the library,
+//   and their evaluation on 64 input patterns at a time.
+//   -e also times the events of the groups selected by the filters, such
+//   as library/cell/pin, the other groups are skipped.
+
+static double seconds_since(const chrono::steady_clock::time_point &start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Best of runs, in seconds
+static double time_parse(const char *filename,const bool use_mmap,const int runs,bool *isok)
+{
+    double best = 0;
+
+    for (int x=0; x<runs; ++x) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        pair<bool,DLIB::Group*>                g     = DLIB::parse_lib_file(filename,use_mmap);
+        const double                           t     = seconds_since(start);
+
+        *isok = *isok && g.first;
+        delete g.second;
+        best = (x == 0 || t < best) ? t : best;
+    }
+    return best;
+}
+
+static double time_lazy(const char *filename,const vector<string> &cells,const int runs,bool *isok)
+{
+    double best = 0;
+
+    for (int x=0; x<runs; ++x) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        pair<bool,DLIB::Group*>                g     = DLIB::parse_lib_file_lazy(filename);
+
+        *isok = *isok && g.first && g.second;
+        for (size_t c=0; *isok && c<cells.size(); ++c) {
+            *isok = g.second->find_group("cell",cells[c].c_str()) != 0;
+        }
+        const double t = seconds_since(start);
+
+        delete g.second;
+        best = (x == 0 || t < best) ? t : best;
+    }
+    return best;
+}
+
+static double time_parallel(const char *filename,const unsigned nthreads,const int runs,bool *isok)
+{
+    double best = 0;
+
+    for (int x=0; x<runs; ++x) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        pair<bool,DLIB::Group*>                g     = DLIB::parse_lib_file_parallel(filename,nthreads);
+        const double                           t     = seconds_since(start);
+
+        *isok = *isok && g.first;
+        delete g.second;
+        best = (x == 0 || t < best) ? t : best;
+    }
+    return best;
+}
+
+// The groups with a values attribute
+static void find_tables(const DLIB::Group *g,vector<const DLIB::Group*> *tables)
+{
+    if (g->find_attr("values")) {
+        tables->push_back(g);
+    }
+    for (DLIB::GroupList::const_iterator x=g->get_subgroups()->begin(); x!=g->get_subgroups()->end(); ++x) {
+        find_tables(*x,tables);
+    }
+}
+
+static void time_tables(const char *filename,bool *isok)
+{
+    pair<bool,DLIB::Group*>    g = DLIB::parse_lib_file(filename);
+    vector<const DLIB::Group*> tables;
+
+    *isok = *isok && g.first && g.second;
+    if (!g.second) {
+        return;
+    }
+    find_tables(g.second,&tables);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    size_t                           count = 0;
+
+    for (size_t x=0; x<tables.size(); ++x) {
+        const DLIB::ArgList *rows = tables[x]->find_attr("values")->get_complex();
+
+        if (!rows) {
+            continue;
+        }
+        for (DLIB::ArgList::const_iterator r=rows->begin(); r!=rows->end(); ++r) {
+            count += (*r)->get_text_as_vector().size();
+        }
+    }
+    const double tvector = seconds_since(start);
+
+    vector<const DLIB::LookupTable*> luts;
+
+    start = chrono::steady_clock::now();
+    for (size_t x=0; x<tables.size(); ++x) {
+        const DLIB::LookupTable *t = tables[x]->get_lookup_table(g.second);
+
+        if (t) {
+            luts.push_back(t);
+        }
+    }
+    const double tdecode = seconds_since(start);
+
+    // The same points for all tables, over their indexes and past them
+    const size_t  batch = 1024;
+    const size_t  total = 4 << 20;
+    vector<float> px(batch),py(batch),single(batch),batched(batch),arcs(luts.size());
+    float         xmax  = 0,ymax = 0;
+
+    for (size_t x=0; x<luts.size(); ++x) {
+        xmax = luts[x]->get_index(1) ? max(xmax,luts[x]->get_index(1)[luts[x]->get_size(1)-1]) : xmax;
+        ymax = luts[x]->get_index(2) ? max(ymax,luts[x]->get_index(2)[luts[x]->get_size(2)-1]) : ymax;
+    }
+    for (size_t x=0; x<batch; ++x) {
+        px[x] = xmax * 1.2f * float(x % 97) / 96;
+        py[x] = ymax * 1.2f * float(x % 89) / 88;
+    }
+    float sum = 0;
+
+    start = chrono::steady_clock::now();
+    for (size_t n=0,t=0; !luts.empty() && n<total; n+=batch,t=(t+1) % luts.size()) {
+        for (size_t x=0; x<batch; ++x) {
+            single[x] = luts[t]->interpolate(px[x],py[x]);
+        }
+        sum += single[n % batch];
+    }
+    const double tsingle = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t n=0,t=0; !luts.empty() && n<total; n+=batch,t=(t+1) % luts.size()) {
+        luts[t]->interpolate(px.data(),py.data(),batched.data(),batch);
+        sum += batched[n % batch];
+    }
+    const double tbatch = seconds_since(start);
+
+    start = chrono::steady_clock::now();
+    for (size_t n=0,p=0; !luts.empty() && n<total; n+=luts.size(),p=(p+1) % batch) {
+        DLIB::LookupTable::interpolate(luts.data(),luts.size(),px[p],py[p],arcs.data());
+        sum += arcs[p % luts.size()];
+    }
+    const double tarcs = seconds_since(start);
+
+    // Both paths must agree on every point of every table
+    for (size_t t=0; t<luts.size(); ++t) {
+        luts[t]->interpolate(px.data(),py.data(),batched.data(),batch);
+        for (size_t x=0; x<batch; ++x) {
+            *isok = *isok && batched[x] == luts[t]->interpolate(px[x],py[x]);
+        }
+    }
+    printf("    tables %zu of %zu decoded in %.3f s, get_text_as_vector %.3f s (%zu values)\n",
+           luts.size(),tables.size(),tdecode,tvector,count);
+    printf("    interpolate %6.1f M lookups/s one by one, %6.1f M/s batched, %6.1f M/s across tables (checksum %g)\n",
+           total / tsingle / 1e6,total / tbatch / 1e6,total / tarcs / 1e6,sum);
+    delete g.second;
+}
+
+// What find_group() and find_attr() did before groups were indexed
+static const DLIB::Group *scan_group(const DLIB::Group *g,const char *name,const char *arg)
+{
+    for (DLIB::GroupList::const_iterator x=g->get_subgroups()->begin(); x!=g->get_subgroups()->end(); ++x) {
+        const char *a = !strcmp((*x)->get_name(),name) ? (*x)->get_unique_name() : 0;
+
+        if (a && !strcmp(a,arg)) {
+            return *x;
+        }
+    }
+    return 0;
+}
+
+static const DLIB::Attr *scan_attr(const DLIB::Group *g,const char *name)
+{
+    for (DLIB::AttrList::const_iterator x=g->get_attrs()->begin(); x!=g->get_attrs()->end(); ++x) {
+        if (!strcmp((*x)->get_name(),name)) {
+            return *x;
+        }
+    }
+    return 0;
+}
+
+static void time_queries(const char *filename,bool *isok)
+{
+    pair<bool,DLIB::Group*> g = DLIB::parse_lib_file(filename);
+    vector<string>          names;
+
+    *isok = *isok && g.first && g.second;
+    if (!g.second) {
+        return;
+    }
+    for (const DLIB::Group *cell : g.second->find_group_range("cell")) {
+        if (cell->get_unique_name()) {
+            names.push_back(cell->get_unique_name());
+            names.push_back(names.back() + "_missing");
+        }
+    }
+    // At least a million queries, each cell is looked up once as a hit and once as a miss
+    const size_t rounds = names.empty() ? 0 : 1 + 1000000 / names.size();
+    size_t       found  = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t r=0; r<rounds; ++r) {
+        for (size_t x=0; x<names.size(); ++x) {
+            const DLIB::Group *cell = g.second->find_group("cell",names[x].c_str());
+
+            found += cell && cell->find_attr("area");
+        }
+    }
+    const double tindex = seconds_since(start);
+    size_t       scanned = 0;
+
+    // The scan is quadratic in the cells, a single round is enough
+    start = chrono::steady_clock::now();
+    for (size_t x=0; x<names.size(); ++x) {
+        const DLIB::Group *cell = scan_group(g.second,"cell",names[x].c_str());
+
+        scanned += cell && scan_attr(cell,"area");
+    }
+    const double tscan = seconds_since(start);
+
+    *isok = *isok && found == scanned * rounds;
+    printf("    query %8.1f M lookups/s indexed, %8.3f M/s scanned, %zu cells (%zu with an area)\n",
+           rounds * names.size() / tindex / 1e6,names.size() / tscan / 1e6,names.size() / 2,scanned);
+    delete g.second;
+}
+
+static void time_functions(const char *filename,bool *isok)
+{
+    pair<bool,DLIB::Group*>   g = DLIB::parse_lib_file(filename);
+    vector<const DLIB::Attr*> attrs;
+
+    *isok = *isok && g.first && g.second;
+    if (!g.second) {
+        return;
+    }
+    for (const DLIB::Group *cell : g.second->find_group_range("cell")) {
+        for (const DLIB::Group *pin : cell->find_group_range("pin")) {
+            for (const char *name : {"function","three_state"}) {
+                if (pin->find_attr(name)) {
+                    attrs.push_back(pin->find_attr(name));
+                }
+            }
+        }
+    }
+    vector<const DLIB::Function*> functions;
+    size_t                        tables = 0;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t x=0; x<attrs.size(); ++x) {
+        const DLIB::Function *f = attrs[x]->get_function();
+
+        if (f) {
+            functions.push_back(f);
+            tables += f->has_truth_table();
+        }
+    }
+    const double tcompile = seconds_since(start);
+
+    // Random input patterns, the same for all functions
+    vector<uint64_t> inputs(256);
+    uint64_t         seed = 0x9E3779B97F4A7C15ULL,sum = 0;
+    const size_t     total = 64 << 20;
+    size_t           words = 0;
+
+    for (size_t x=0; x<inputs.size(); ++x) {
+        seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+        inputs[x] = seed;
+    }
+    start = chrono::steady_clock::now();
+    for (size_t n=0,f=0; !functions.empty() && n<total; n+=64,f=(f+1) % functions.size(),++words) {
+        if (functions[f]->get_inputs() < inputs.size()) {
+            sum += functions[f]->evaluate(&inputs[words % (inputs.size() - functions[f]->get_inputs())]);
+        }
+    }
+    const double teval = seconds_since(start);
+
+    printf("    funcs %zu of %zu compiled in %.3f s, %zu truth tables, %.1f M patterns/s (checksum %llx)\n",
+           functions.size(),attrs.size(),tcompile,tables,functions.empty() ? 0 : total / teval / 1e6,
+           static_cast<unsigned long long>(sum));
+    delete g.second;
+}
+
+// Counts the events
+class EventCounter : public DLIB::EventHandler {
+public:
+    size_t groups,attrs;
+
+    EventCounter():groups(0),attrs(0) {}
+
+    void begin_group(const DLIB::GroupPath &path,const DLIB::ArgList *args) {++groups;}
+    void attribute(const DLIB::GroupPath &path,const DLIB::Attr *attr)      {++attrs;}
+};
+
+static double time_events(const char *filename,const vector<const char*> &filters,const int runs,EventCounter *count,bool *isok)
+{
+    double best = 0;
+
+    for (int x=0; x<runs; ++x) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        *count = EventCounter();
+        *isok  = DLIB::parse_lib_file_events(filename,count,filters) && *isok;
+
+        const double t = seconds_since(start);
+
+        best = (x == 0 || t < best) ? t : best;
+    }
+    return best;
+}
+
+static double time_cache(const char *filename,const int runs,bool *isok)
+{
+    double best = 0;
+
+    for (int x=0; x<runs; ++x) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        DLIB::Group                           *g     = DLIB::load_lib_cache(filename,0);
+        const double                           t     = seconds_since(start);
+
+        *isok = *isok && g;
+        delete g;
+        best = (x == 0 || t < best) ? t : best;
+    }
+    return best;
+}
+
+int main(int argc,char **argv)
+{
+    int         runs     = 3;
+    bool        cache    = false;
+    int         percent  = -1;
+    int         threads  = -1;
+    bool        tables   = false;
+    bool        tokens   = false;
+    bool        queries  = false;
+    bool        funcs    = false;
+    const char *filename = 0;
+    vector<const char*> filters;
+
+    for (int x=1; x<argc; ++x) {
+        if (!strcmp(argv[x],"-n") && x+1 < argc) {
+            runs = atoi(argv[++x]);
+        } else if (!strcmp(argv[x],"-c")) {
+            cache = true;
+        } else if (!strcmp(argv[x],"-l") && x+1 < argc) {
+            percent = atoi(argv[++x]);
+        } else if (!strcmp(argv[x],"-t") && x+1 < argc) {
+            threads = atoi(argv[++x]);
+        } else if (!strcmp(argv[x],"-u")) {
+            tables = true;
+        } else if (!strcmp(argv[x],"-k")) {
+            tokens = true;
+        } else if (!strcmp(argv[x],"-q")) {
+            queries = true;
+        } else if (!strcmp(argv[x],"-f")) {
+            funcs = true;
+        } else if (!strcmp(argv[x],"-e") && x+1 < argc) {
+            filters.push_back(argv[++x]);
+        } else {
+            filename = argv[x];
+        }
+    }
+    struct stat st;
+    if (!filename || stat(filename,&st)) {
+        printf("Usage: %s [-n runs] [-c] [-l percent] [-t threads] [-u] [-k] [-q] [-f] [-e filter]... file\n",argv[0]);
+        return 1;
+    }
+    const double mb   = st.st_size / 1e6;
+    bool         isok = true;
+
+    // The cache is timed first, as in a fresh run of a tool, the parses
+    // below leave a fragmented heap behind them
+    double tcache = 0;
+    size_t csize  = 0;
+
+    if (cache) {
+        pair<bool,DLIB::Group*> g = DLIB::parse_lib_file_cached(filename);
+        const string            cachefile = string(filename) + ".dlibc";
+        struct stat             cs;
+
+        isok = isok && g.first;
+        delete g.second;
+        if (stat(cachefile.c_str(),&cs)) {
+            printf("%s: cache not written\n",filename);
+            return 1;
+        }
+        csize  = cs.st_size;
+        tcache = time_cache(filename,runs,&isok);
+    }
+    printf("%s: %.1f MB, best of %d runs\n",filename,mb,runs);
+    const double tio  = time_parse(filename,false,runs,&isok);
+    printf("    stdio %8.3f s %8.1f MB/s\n",tio,mb / tio);
+    const double tmap = time_parse(filename,true,runs,&isok);
+    printf("    mmap  %8.3f s %8.1f MB/s\n",tmap,mb / tmap);
+    if (tokens) {
+        DLIB::use_hand_written_tokenizer(true);
+
+        const double ttok = time_parse(filename,true,runs,&isok);
+
+        DLIB::use_hand_written_tokenizer(false);
+        printf("    token %8.3f s %8.1f MB/s, %.1fx faster than mmap\n",ttok,mb / ttok,tmap / ttok);
+    }
+    if (cache) {
+        printf("    cache %8.3f s %8.1f MB/s of source, %.1f MB cache, %.1fx faster than mmap\n",
+               tcache,mb / tcache,csize / 1e6,tmap / tcache);
+    }
+    if (percent >= 0) {
+        pair<bool,DLIB::Group*>          g     = DLIB::parse_lib_file(filename);
+        const vector<const DLIB::Group*> all   = g.second ? g.second->find_groups("cell") : vector<const DLIB::Group*>();
+        vector<string>                   cells;
+        size_t                           total = 0;
+
+        for (size_t x=0; x<all.size(); ++x) {
+            const char *n = all[x]->get_unique_name();
+
+            if (n && (total++ * percent) % 100 < size_t(percent)) {
+                cells.push_back(n);
+            }
+        }
+        delete g.second;
+
+        const double tlazy = time_lazy(filename,cells,runs,&isok);
+        printf("    lazy  %8.3f s %8.1f MB/s, %zu of %zu cells looked up, %.1fx faster than mmap\n",
+               tlazy,mb / tlazy,cells.size(),total,tmap / tlazy);
+    }
+    if (threads >= 0) {
+        const double tpar = time_parallel(filename,threads,runs,&isok);
+        printf("    par   %8.3f s %8.1f MB/s, %.1fx faster than mmap\n",tpar,mb / tpar,tmap / tpar);
+    }
+    if (tables) {
+        time_tables(filename,&isok);
+    }
+    if (queries) {
+        time_queries(filename,&isok);
+    }
+    if (funcs) {
+        time_functions(filename,&isok);
+    }
+    if (!filters.empty()) {
+        EventCounter count;
+        const double tevents = time_events(filename,filters,runs,&count,&isok);
+
+        printf("    event %8.3f s %8.1f MB/s, %zu groups and %zu attributes delivered, %.1fx faster than mmap\n",
+               tevents,mb / tevents,count.groups,count.attrs,tmap / tevents);
+    }
+
+    return isok ? 0 : 1;
+}
@@ -116,7 +116,22 @@ static void display_group(const DLIB::Group *g,const string &indent) {
 int main(int argc,char **argv)
 {
     pair<bool,DLIB::Group*> g = make_pair(true,static_cast<DLIB::Group*>(0));
-    const bool print = (argc > 1) ? strcmp(argv[1],"-p") == 0 : false;
+    bool print  = false;
+    bool cached = false;
+    bool lazy   = false;
+    bool thread = false;
+
+    // -p prints the library, -c reads it through its binary cache, -l parses its cells when needed,
+    // -t parses its groups on several threads, -k uses the hand written tokenizer
+    for (int x=1; x<argc-1; ++x) {
+        print  = print  || !strcmp(argv[x],"-p");
+        cached = cached || !strcmp(argv[x],"-c");
+        lazy   = lazy   || !strcmp(argv[x],"-l");
+        thread = thread || !strcmp(argv[x],"-t");
+        if (!strcmp(argv[x],"-k")) {
+            DLIB::use_hand_written_tokenizer(true);
+        }
+    }
 
     if ( argc > 1 ) {
         if ((argc > 2) && (!strcmp("-e",argv[1]))) {
@@ -125,7 +140,9 @@ int main(int argc,char **argv)
             return e.first ? 0 : 1;
         }
         printf("Reading library %s\n",argv[argc-1]);
-        g = DLIB::parse_lib_file(argv[argc-1]);
+        g = cached ? DLIB::parse_lib_file_cached(argv[argc-1]) :
+            lazy   ? DLIB::parse_lib_file_lazy(argv[argc-1])   :
+            thread ? DLIB::parse_lib_file_parallel(argv[argc-1]) : DLIB::parse_lib_file(argv[argc-1]);
     } else {
         g = DLIB::parse_lib_file(0);
     }
@@ -0,0 +1,54 @@
+// .LIB tokenizer check
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <vector>
+#include "libobjects.hxx"
+#include "libparser.hxx"
+
+using namespace std;
+
+// Usage: libtokdiff.exe file...
+//   Compares the tokens of the flex scanner and of the hand written
+//   tokenizer (see DLIB::use_hand_written_tokenizer()) on each file, and
+//   reports the first difference.
+
+static bool read_file(const char *filename,vector<char> *text)
+{
+    FILE *f = fopen(filename,"rb");
+    char  buf[65536];
+    size_t n;
+
+    if (!f) {
+        return false;
+    }
+    while ((n = fread(buf,1,sizeof(buf),f)) > 0) {
+        text->insert(text->end(),buf,buf + n);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc,char **argv)
+{
+    bool isok = argc > 1;
+
+    for (int x=1; x<argc; ++x) {
+        vector<char> text;
+        size_t       ntokens;
+
+        if (!read_file(argv[x],&text)) {
+            printf("%s: cannot open\n",argv[x]);
+            isok = false;
+        } else if (DLIB::diff_lib_tokens(text.data(),text.size(),&ntokens)) {
+            printf("%s: %zu tokens, identical\n",argv[x],ntokens);
+        } else {
+            printf("%s: differs after %zu tokens\n",argv[x],ntokens);
+            isok = false;
+        }
+    }
+    if (argc < 2) {
+        printf("Usage: %s file...\n",argv[0]);
+    }
+    return isok ? 0 : 1;
+}
@@ -7,8 +7,10 @@
 #ifndef DLIB_OBJECTS_H
 #define DLIB_OBJECTS_H
 
+#include <stdint.h>
 #include <list>
 #include <vector>
+#include <atomic>
 
 /// DLIB is the namespace that contains the .LIB parser. General API information follows
 /** The following rules apply in all of the API calls in this library
@@ -26,19 +28,84 @@ namespace DLIB {
     class Arg;
     class Expr;
     class BitExpr;
+    class LookupTable;
+    class Function;
+    class EventHandler;
 
     /// This is the main parsing function
     /** @param filename is the path to the filename to be parsed
+        @param use_mmap when set to true, regular files are memory mapped and scanned in place, other files (pipes, stdin) are always read through stdio
         @return a pair which contains the status (bool) and the top level group (typically the library).
         @attention the returned Group pointer must be freed to release the memory when you're finished using it
     */
-    pair<bool,Group*>   parse_lib_file(const char *filename);
+    pair<bool,Group*>   parse_lib_file(const char *filename,const bool use_mmap=true);
+    /// Same as parse_lib_file(), except that the cells of the library are only parsed when first needed
+    /** The top level cell groups are located by a quick scan of filename, which stays mapped in memory.
+        A cell is parsed the first time it is looked up by name with Group::find_group(), all of them are
+        parsed by Group::find_groups("cell"), Group::find_group_range("cell") or Group::get_subgroups().
+        Files that can't be mapped (pipes, stdin) are parsed at once.
+        @param filename is the path to the filename to be parsed
+        @return same as parse_lib_file(), syntax errors in a cell are only reported when the cell is parsed
+    */
+    pair<bool,Group*>   parse_lib_file_lazy(const char *filename);
+    /// Same as parse_lib_file(), with the top level groups of the library parsed on several threads
+    /** The groups are located by a quick scan of filename and added to the library in file order, the result
+        is the same as parse_lib_file(). Files that can't be mapped (pipes, stdin) are parsed sequentially.
+        @param filename is the path to the filename to be parsed
+        @param nthreads is the number of threads, 0 for one per hardware thread
+        @return same as parse_lib_file()
+    */
+    pair<bool,Group*>   parse_lib_file_parallel(const char *filename,const unsigned nthreads=0);
+    /// Same as parse_lib_file(), through a binary cache of the parsed library
+    /** The cache is loaded instead of parsing filename when it was written for the current content of filename,
+        otherwise filename is parsed and the cache is written again.
+        @param filename is the path to the filename to be parsed
+        @param cachefile is the path of the cache, by default filename followed by ".dlibc"
+        @return same as parse_lib_file()
+    */
+    pair<bool,Group*>   parse_lib_file_cached(const char *filename,const char *cachefile=0);
+    /// Reads a library as a sequence of events (see EventHandler) instead of building its groups
+    /** The groups of interest are selected by filters, paths of group names from the top level group separated
+        by '/', such as "library/cell/pin". A name "*" matches any group, "**" any number of nested groups,
+        so "**&#47;timing" selects the timing groups at any depth. Names are not case sensitive.
+        A group whose path matches a filter is delivered with all it holds. The groups that lead to it only get
+        their begin_group() and end_group() events. The other groups are skipped without being parsed, so that
+        a few cell attributes are read from a large library in little time and memory.
+        The file is read as parse_lib_file() reads it, with the tokenizer selected by use_hand_written_tokenizer().
+        @param filename is the path to the filename to be read
+        @param handler receives the events
+        @param filters are the paths of the groups to deliver, all the groups when there is none
+        @return false on syntax errors or when filename can't be read
+    */
+    bool                parse_lib_file_events(const char *filename,EventHandler *handler,const vector<const char*> &filters=vector<const char*>());
+    /// Writes a binary cache of a library parsed from filename, see load_lib_cache()
+    /** @return false if the cache could not be written */
+    bool                save_lib_cache(const Group *lib,const char *filename,const char *cachefile);
+    /// Loads a library from a cache written by save_lib_cache(), without parsing
+    /** The cache is current when filename has the size and modification time it had when the cache was written.
+        When only the modification time differs, the content of filename is hashed and compared instead.
+        @return the top level group, 0 if the cache is missing, out of date or corrupted
+        @attention the returned Group pointer must be freed to release the memory when you're finished using it
+        @note a cache is only readable on machines of the same byte order as the writer
+    */
+    Group              *load_lib_cache(const char *filename,const char *cachefile);
+    /// Selects the tokenizer used to parse files that are memory mapped (the parse functions above)
+    /** @param enable true for a hand written tokenizer, which returns the same tokens as the flex scanner in less time,
+        false for the flex scanner (the default). Files read through stdio always use the flex scanner
+        @note check that both return the same tokens on your libraries with libtokdiff.exe before enabling it
+    */
+    void                use_hand_written_tokenizer(const bool enable);
     /// Parses a string expression such as "(!(A B) | (C ^ D')'))"
     /** @param char buffer containing the expression string to be parsed
         @return a pair which contains the status (bool) and the resulting expression.
         @attention the returned expression pointer must be freed to release the memory when you're finished using it
     */
     pair<bool,Expr*>    parse_expression_string(const char *expr);
+    /// Parses and compiles a logic expression such as "!(A B) | C", see class Function
+    /** @return a pair which contains the status (bool) and the compiled function, 0 if the expression doesn't parse
+        @attention the returned function pointer must be freed to release the memory when you're finished using it
+    */
+    pair<bool,Function*> compile_function_string(const char *expr);
 
     /// This class contains a list of groups.
     /** It inherits the methods of the STL list class, so simply use STL iterators if you want to iterate through all the objects in this list */
@@ -111,6 +178,8 @@ namespace DLIB {
         const char          *get_keyword()   const;
         /// For a text argument, returns the char string of the text argument with double quotes removed (else returns 0)
         const char          *get_text()      const;
+        /// For a keyword or a text argument, returns its char string as get_keyword() or get_text() do (else returns 0)
+        const char          *get_string()    const;
         /// For a text argument, returns the vector of float represented by the text argument, only use this when the argument is the format "float, float, ..., float". An empty array is returned if invoked with a wrong argument type.
         const vector<float>  get_text_as_vector() const;
         /// For an argument list argument, returns the argument list (else returns 0)
@@ -237,6 +306,115 @@ attribute_name (argument, ..., argument); @endcode
         Attr(const char *name,const Expr    *expr);                  ///< @internal
         Attr(const char *name,const BitExpr *bit_expr);              ///< @internal
         ~Attr();
+
+        /// Returns the logic function of a function, three_state or when attribute (for example "!(A B) | C")
+        /** The expression is compiled by the first call and kept with the attribute, the following calls return it at once.
+            @return 0 if the attribute is not a logic expression
+        */
+        const Function *get_function() const;
+    private:
+        mutable atomic<Function*> _function;  // Compiled by get_function()
+    };
+
+    /// Represents a timing or power table (cell_rise, rise_transition, rise_power...) decoded for interpolation
+    /** The indexes and values of a table group are decoded once into float arrays, the indexes missing from the
+        group are those of its template (lu_table_template or power_lut_template). Tables of 1 or 2 dimensions
+        and scalar tables are supported. Example: @code
+const DLIB::LookupTable *t = cell_rise_group->get_lookup_table(library_group);
+float delay = t ? t->interpolate(transition,load) : 0; @endcode
+        \sa Group::get_lookup_table()
+    */
+    class LookupTable {
+    public:
+        /// Returns the name of the template of the table, 0 if it has none
+        const char  *get_template()               const;
+        /// Returns the number of dimensions: 0 for a scalar table, 1 or 2
+        unsigned     get_dimensions()             const;
+        /// Returns the variable of index_1 or index_2 (for example input_net_transition), 0 if the template doesn't define it
+        const char  *get_variable(const unsigned n) const;
+        /// Returns the number of values of index_1 or index_2, 1 for a missing dimension
+        unsigned     get_size(const unsigned n)     const;
+        /// Returns the values of index_1 or index_2, 0 for a missing dimension
+        const float *get_index(const unsigned n)    const;
+        /// Returns the values of the table, index_2 varies the fastest
+        const float *get_values()                 const;
+        /// Interpolates the table at x for index_1 and y for index_2, bilinearly, extrapolates outside the indexes
+        /** y is ignored by tables of 1 dimension, x and y by scalar tables. Does not allocate. */
+        float        interpolate(const float x,const float y=0) const;
+        /// Interpolates the n points (x[k],y[k]) into out[k], with the same results as interpolate()
+        /** Points are evaluated 8 at a time with AVX2 when the processor has it. y may be 0 for tables of less than 2 dimensions. */
+        void         interpolate(const float *x,const float *y,float *out,const size_t n) const;
+        /// Interpolates the point (x,y) in each of the n tables (for example all the arcs of a pin) into out[k]
+        static void  interpolate(const LookupTable *const *tables,const size_t n,const float x,const float y,float *out);
+
+        LookupTable(const Group *table,const Group *library);  ///< @internal
+        bool         is_valid()                   const;         ///< @internal
+    private:
+        const char   *_template;
+        const char   *_variables[2];
+        vector<float> _indexes[2];
+        vector<float> _values;
+        unsigned      _dims;
+        bool          _isok;
+    };
+
+    /// Represents a logic expression compiled for evaluation, 64 input patterns at a time
+    /** The inputs are the pins (or bus bits, for example "a[3]", in lower case like BitExpr names) of the expression,
+        in order of first appearance.
+        Functions of up to 6 inputs are kept as a truth table, wider ones as a flat program. Example: @code
+const DLIB::Function *f = function_attr->get_function();
+uint64_t in[2] = {a_values,b_values};  // 64 patterns, input 0 is f->get_input(0)
+uint64_t out   = f->evaluate(in); @endcode
+        \sa Attr::get_function(), compile_function_string()
+    */
+    class Function {
+    public:
+        /// Returns the number of inputs
+        unsigned     get_inputs()                  const;
+        /// Returns the name of input n
+        const char  *get_input(const unsigned n)   const;
+        /// Returns the input of a pin name, -1 if the function doesn't depend on it
+        int          find_input(const char *name)  const;
+        /// Returns true if the function has at most 6 inputs and so a truth table
+        bool         has_truth_table()             const;
+        /// Returns the truth table: bit k is the value of the function when input i is bit i of k
+        /** Only valid when has_truth_table() */
+        uint64_t     get_truth_table()             const;
+        /// Evaluates 64 input patterns: bit k of inputs[i] is the value of input i in pattern k
+        /** @return bit k is the value of the function for pattern k */
+        uint64_t     evaluate(const uint64_t *inputs) const;
+        /// Returns true if the functions have the same value for all the patterns of their inputs, matched by name
+        /** All the patterns are enumerated, so the functions should have at most 24 inputs together. */
+        bool         is_equivalent(const Function *f) const;
+
+        Function(const Expr *e);  ///< @internal
+        bool         is_valid()                    const;  ///< @internal
+    private:
+        vector<const char*> _inputs;
+        vector<uint32_t>    _code;   // Postfix program: op in the low byte, input above, empty with a truth table
+        uint64_t            _table;
+        unsigned            _depth;  // Of the program stack
+        bool                _isok;
+
+        void         compile(const Expr *e);
+        void         compile(const Arg  *a);
+        void         run(const uint64_t *inputs,uint64_t *stack) const;
+    };
+
+    /// The subgroups of one name of a group, in file order, see Group::find_group_range()
+    /** Iterate with begin() and end(), or a range based for loop. The range stays valid as long as the group. */
+    class GroupRange {
+    public:
+        typedef const Group *const *const_iterator;
+
+        const_iterator begin() const {return _begin;}
+        const_iterator end()   const {return _end;}
+        size_t         size()  const {return _end - _begin;}
+        bool           empty() const {return _begin == _end;}
+
+        GroupRange(const_iterator b,const_iterator e):_begin(b),_end(e) {}  ///< @internal
+    private:
+        const_iterator _begin,_end;
     };
 
     /// This class stores the .LIB groups informations
@@ -244,6 +422,8 @@ attribute_name (argument, ..., argument); @endcode
 group_name (arglist) {
     group_body
 } @endcode
+        Lookups by name never modify the library: the names are not interned, and the indexes of a group are
+        built on its first lookup. Any number of threads may look up a library at the same time.
     */
     class Group : public Object {
     public:
@@ -272,18 +452,75 @@ group_name (arglist) {
         */ 
         const Arg       *get_unique_arg()            const;
 
+        /// Returns the name given by the single argument of a group, such as the name of a cell or of a pin
+        /** Example: @code cell_group->get_unique_name() @endcode
+                     returns "NAND2" for the group cell(NAND2)
+            @return 0 unless the group has a single keyword or text argument
+        */
+        const char      *get_unique_name()           const;
+
         /// Retrieves the groups that match the name argument, note name should be a plain text string (not a regular expression).
         /** Example: @code library_group->find_groups("cell") @endcode 
                      returns all the cell groups in your library (library_group being a pointer to the top level group)
         */
         const vector<const Group*> find_groups(const char *name) const;
 
+        /// Retrieves the subgroup that matches the name argument and whose single argument is arg
+        /** Example: @code library_group->find_group("cell","NAND2") @endcode
+                     returns the group of the cell NAND2 (library_group being a pointer to the top level group)
+            @return 0 if there is no such group, otherwise the first one
+        */
+        const Group     *find_group(const char *name,const char *arg) const;
+
+        /// Same as find_groups(), without allocating
+        /** Example: @code for (const DLIB::Group *cell : library_group->find_group_range("cell")) ... @endcode
+            The cells of a lazy library are all parsed by the first call.
+        */
+        GroupRange       find_group_range(const char *name) const;
+
+        /// Returns the decoded table of a timing or power table group (for example cell_rise)
+        /** The table is decoded by the first call and kept with the group, the following calls return it at once.
+            @param library is the top level group, where the template of the table is looked up. Only used by the first call
+            @return 0 if the group is not a valid table (values missing or not matching the indexes, 3 dimensions)
+        */
+        const LookupTable *get_lookup_table(const Group *library) const;
+
         Group(const char *name,const ArgList *args,list<Object*> *objs);  ///< @internal
         ~Group();
     private:
-        const ArgList   *_args;
-        AttrList         _attrs;
-        GroupList        _groups;
+        struct lazy;
+        friend pair<bool,Group*> parse_lib_file_lazy(const char *filename);
+        friend pair<bool,Group*> parse_lib_file_parallel(const char *filename,const unsigned nthreads);
+
+        const ArgList    *_args;
+        AttrList          _attrs;
+        mutable GroupList _groups;  // The cells of a lazy library are added when they are all parsed
+        lazy             *_lazy;    // Cells left to parse, 0 for other groups
+        mutable atomic<LookupTable*> _table;  // Decoded by get_lookup_table()
+
+        struct index;
+        mutable atomic<index*> _index;  // Built by the first lookup
+        const index      *get_index() const;
+
+        void              parse_cells() const;
+    };
+
+    typedef vector<const char*> GroupPath; ///< Names of nested groups, from the top level group, as returned by Object::get_name()
+
+    /// Receives the events of parse_lib_file_events(), derive from it and override the events of interest
+    /** The arguments and attributes are only valid during the call, the path during the events of its group.
+        An attribute is an event of its own, the group is not built.
+    */
+    class EventHandler {
+    public:
+        virtual ~EventHandler() {}
+
+        /// A group starts, path ends with its name
+        virtual void begin_group(const GroupPath &path,const ArgList *args) {}
+        /// An attribute of the group of path
+        virtual void attribute(const GroupPath &path,const Attr *attr)      {}
+        /// The group of path ends
+        virtual void end_group(const GroupPath &path)                       {}
     };
 };
 
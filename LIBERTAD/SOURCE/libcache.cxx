@@ -0,0 +1,551 @@
+// .LIB reader
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "libobjects.hxx"
+#include "LexemeTable.hxx"
+#include "MappedFile.hxx"
+#include "SectionFile.hxx"
+#include "TextHash.hxx"
+
+using namespace std;
+
+extern LexemeTable *DLIB_LEXEMES;
+
+// Cache sections, see SectionFile.hxx for the file layout. The cache's own
+// header identifies the source file by size, modification time and content
+// hash. The attributes and the subgroups of a group are consecutive
+// records, so are the arguments of a list. Nested expressions and argument
+// lists have a lower index than the one they are nested in, subgroups a
+// higher index than their parent, so a corrupted file can't make the
+// loader loop. Loading interns the strings once and constructs the objects
+// as the parser does. Nothing is scanned.
+
+static const char     cache_magic[8] = {'D','L','I','B','C','A','C','\n'};
+static const uint32_t cache_version  = 2;
+static const uint32_t none           = SectionFile::none;
+
+enum {S_GROUPS = SectionFile::FIRST_SECTION, // Top level group first
+      S_ATTRS,
+      S_ARGS,
+      S_ARGLISTS,
+      S_EXPRS,
+      S_BITEXPRS,
+      S_COUNT};
+
+struct cache_source {
+    uint64_t  size;
+    int64_t   mtime;            // Seconds
+    int64_t   mtime_ns;
+    uint32_t  hash;
+    uint32_t  padding;
+};
+
+// The value of an argument depends on its type: a string, the bits of the
+// float, or an index in the arglists, exprs or bitexprs
+struct cache_arg {
+    uint32_t type;
+    uint32_t value;
+};
+
+struct cache_attr {
+    uint32_t  name;
+    cache_arg arg;
+};
+
+struct cache_group {
+    uint32_t name;
+    uint32_t args;              // none for a group without arguments
+    uint32_t first_attr,nattrs;
+    uint32_t first_group,ngroups;
+};
+
+struct cache_arglist {
+    uint32_t first_arg,nargs;
+};
+
+enum {E_FIRST_EXPR = 1,E_SECOND_EXPR = 2};
+
+struct cache_expr {
+    uint32_t type;
+    uint32_t flags;             // E_FIRST_EXPR, E_SECOND_EXPR
+    uint32_t first,second;      // Index in args or exprs, none if absent
+};
+
+struct cache_bitexpr {
+    uint32_t name;
+    uint32_t type;
+    int32_t  first,second;      // Index, or slice
+};
+
+static const size_t record_size[S_COUNT - SectionFile::FIRST_SECTION] = {sizeof(cache_group),sizeof(cache_attr),sizeof(cache_arg),
+                                                                         sizeof(cache_arglist),sizeof(cache_expr),sizeof(cache_bitexpr)};
+
+//-----------------------------------------------------------------------------
+// Source identification
+//-----------------------------------------------------------------------------
+
+static bool get_source_id(const char *filename,cache_source *id)
+{
+    struct stat st;
+
+    if (!filename || stat(filename,&st) || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    id->size     = st.st_size;
+    id->mtime    = st.st_mtim.tv_sec;
+    id->mtime_ns = st.st_mtim.tv_nsec;
+    return true;
+}
+
+static bool get_source_hash(const char *filename,uint32_t *hash)
+{
+    MappedFile m;
+
+    if (!m.open(filename)) {
+        return false;
+    }
+    *hash = hash_text(m.data(),m.size());
+    return true;
+}
+
+static string default_cache(const char *filename,const char *cachefile)
+{
+    return cachefile ? string(cachefile) : string(filename) + ".dlibc";
+}
+
+//-----------------------------------------------------------------------------
+// Save
+//-----------------------------------------------------------------------------
+
+struct cache_writer {
+    SectionWriter          file;
+    vector<cache_group>    groups;
+    vector<cache_attr>     attrs;
+    vector<cache_arg>      args;
+    vector<cache_arglist>  arglists;
+    vector<cache_expr>     exprs;
+    vector<cache_bitexpr>  bitexprs;
+
+    uint32_t  string_id(const char *s) {return file.add_string(s);}
+    cache_arg arg(const DLIB::Arg *a);
+    uint32_t  arg_id(const DLIB::Arg *a);
+    uint32_t  arglist(const DLIB::ArgList *l);
+    uint32_t  expr(const DLIB::Expr *e);
+    uint32_t  bitexpr(const DLIB::BitExpr *e);
+    void      group(const DLIB::Group *g,const size_t x);
+};
+
+cache_arg cache_writer::arg(const DLIB::Arg *a)
+{
+    cache_arg r = {static_cast<uint32_t>(a->get_type()),none};
+
+    switch (a->get_type()) {
+    case DLIB::Arg::T_NUMBER: {
+        const float f = a->get_number();
+
+        memcpy(&r.value,&f,sizeof(r.value));
+        break;
+    }
+    case DLIB::Arg::T_KEYWORD:  r.value = string_id(a->get_keyword());       break;
+    case DLIB::Arg::T_TEXT:     r.value = string_id(a->get_text());          break;
+    case DLIB::Arg::T_COMPLEX:  r.value = arglist(a->get_complex());         break;
+    case DLIB::Arg::T_EXPR:     r.value = expr(a->get_expr());               break;
+    case DLIB::Arg::T_BIT_EXPR: r.value = bitexpr(a->get_bit_expr());        break;
+    default:                                                                 break;
+    }
+    return r;
+}
+
+uint32_t cache_writer::arg_id(const DLIB::Arg *a)
+{
+    const cache_arg ca = arg(a);
+
+    args.push_back(ca);
+    return static_cast<uint32_t>(args.size() - 1);
+}
+
+// The arguments are placed before the lists nested in them are written
+uint32_t cache_writer::arglist(const DLIB::ArgList *l)
+{
+    if (!l) {
+        return none;
+    }
+    cache_arglist r = {static_cast<uint32_t>(args.size()),static_cast<uint32_t>(l->size())};
+    uint32_t      x = r.first_arg;
+
+    args.resize(args.size() + l->size());
+    for (DLIB::ArgList::const_iterator a=l->begin(); a!=l->end(); ++a) {
+        const cache_arg ca = arg(*a);
+
+        args[x++] = ca;
+    }
+    arglists.push_back(r);
+    return static_cast<uint32_t>(arglists.size() - 1);
+}
+
+uint32_t cache_writer::expr(const DLIB::Expr *e)
+{
+    if (!e) {
+        return none;
+    }
+    cache_expr r = {static_cast<uint32_t>(e->get_type()),0,none,none};
+
+    if (e->is_first_expr()) {
+        r.flags |= E_FIRST_EXPR;
+        r.first  = expr(e->get_first_expr());
+    } else if (e->get_first_arg()) {
+        r.first  = arg_id(e->get_first_arg());
+    }
+    if (e->is_second_expr()) {
+        r.flags |= E_SECOND_EXPR;
+        r.second = expr(e->get_second_expr());
+    } else if (e->get_second_arg()) {
+        r.second = arg_id(e->get_second_arg());
+    }
+    exprs.push_back(r);
+    return static_cast<uint32_t>(exprs.size() - 1);
+}
+
+uint32_t cache_writer::bitexpr(const DLIB::BitExpr *e)
+{
+    if (!e) {
+        return none;
+    }
+    cache_bitexpr r = {string_id(e->get_name()),static_cast<uint32_t>(e->get_type()),-1,-1};
+
+    if (e->get_type() == DLIB::BitExpr::T_INDEX) {
+        r.first  = e->get_index();
+    } else {
+        r.first  = e->get_from();
+        r.second = e->get_to();
+    }
+    bitexprs.push_back(r);
+    return static_cast<uint32_t>(bitexprs.size() - 1);
+}
+
+// The subgroups of g are placed before any of them is written
+void cache_writer::group(const DLIB::Group *g,const size_t x)
+{
+    const DLIB::AttrList  *al = g->get_attrs();
+    const DLIB::GroupList *gl = g->get_subgroups();
+    cache_group            r;
+
+    r.name        = string_id(g->get_name());
+    r.args        = arglist(g->get_args());
+    r.first_attr  = static_cast<uint32_t>(attrs.size());
+    r.nattrs      = static_cast<uint32_t>(al->size());
+    r.first_group = static_cast<uint32_t>(groups.size());
+    r.ngroups     = static_cast<uint32_t>(gl->size());
+
+    attrs.resize(attrs.size() + al->size());
+    uint32_t a = r.first_attr;
+    for (DLIB::AttrList::const_iterator i=al->begin(); i!=al->end(); ++i) {
+        cache_attr ca;
+
+        ca.name     = string_id((*i)->get_name());
+        ca.arg      = arg(*i);
+        attrs[a++]  = ca;
+    }
+    groups[x] = r;
+    groups.resize(groups.size() + gl->size());
+
+    size_t s = r.first_group;
+    for (DLIB::GroupList::const_iterator i=gl->begin(); i!=gl->end(); ++i) {
+        group(*i,s++);
+    }
+}
+
+// The cache is written next to its final path and renamed, so that a tool
+// reading it at the same time never sees a partial file
+bool DLIB::save_lib_cache(const Group *lib,const char *filename,const char *cachefile)
+{
+    cache_source id;
+    cache_writer w;
+
+    memset(&id,0,sizeof(id));
+    if (!lib || !filename || !get_source_id(filename,&id) || !get_source_hash(filename,&id.hash)) {
+        printf("LIB-005: Cannot cache %s\n",filename);
+        return false;
+    }
+    w.groups.resize(1);
+    w.group(lib,0);
+    if (w.file.get_string_bytes() >= none || w.args.size() >= none || w.groups.size() >= none || w.attrs.size() >= none) {
+        printf("LIB-005: Library too large for a cache\n");
+        return false;
+    }
+    const string path = default_cache(filename,cachefile);
+    const string temp = path + ".tmp";
+
+    bool isok = w.file.open(temp.c_str(),cache_magic,cache_version,S_COUNT,&id,sizeof(id));
+
+    isok = isok && w.file.write(w.groups);
+    isok = isok && w.file.write(w.attrs);
+    isok = isok && w.file.write(w.args);
+    isok = isok && w.file.write(w.arglists);
+    isok = isok && w.file.write(w.exprs);
+    isok = isok && w.file.write(w.bitexprs);
+    isok = w.file.close() && isok;
+    isok = isok && rename(temp.c_str(),path.c_str()) == 0;
+    if (!isok) {
+        printf("LIB-005: Cannot write %s\n",path.c_str());
+        remove(temp.c_str());
+    }
+    return isok;
+}
+
+//-----------------------------------------------------------------------------
+// Load
+//-----------------------------------------------------------------------------
+
+// The limits passed down the recursion are the index of the expression and
+// of the argument list being built: nested ones must be lower.
+struct cache_reader {
+    SectionReader        file;
+    vector<const char*>  strings;   // Interned
+
+    template <class T> const T *section(const int s) const {return file.section<T>(s);}
+
+    // Checks an index read from the file, a bad one leaves an empty string or a null object
+    bool           valid(const uint32_t x,const int s,const uint32_t n=1) {return file.valid(x,s,n);}
+    bool           below(const uint32_t x,const uint32_t limit)           {return file.below(x,limit);}
+    const char    *string(const uint32_t x) {return valid(x,SectionFile::OFFSETS) ? strings[x] : "";}
+    DLIB::Arg     *arg(const uint32_t x,const uint32_t elimit,const uint32_t alimit);
+    DLIB::ArgList *arglist(const uint32_t x,const uint32_t elimit,const uint32_t alimit);
+    DLIB::Expr    *expr(const uint32_t x,const uint32_t elimit,const uint32_t alimit);
+    DLIB::BitExpr *bitexpr(const uint32_t x);
+    DLIB::Attr    *attr(const cache_attr &r);
+    DLIB::Group   *group(const uint32_t x);
+};
+
+DLIB::Arg *cache_reader::arg(const uint32_t x,const uint32_t elimit,const uint32_t alimit)
+{
+    if (!valid(x,S_ARGS)) {
+        return 0;
+    }
+    const cache_arg &r = section<cache_arg>(S_ARGS)[x];
+    float            f;
+
+    switch (r.type) {
+    case DLIB::Arg::T_NUMBER:
+        memcpy(&f,&r.value,sizeof(f));
+        return new DLIB::Arg(f);
+    case DLIB::Arg::T_KEYWORD:
+    case DLIB::Arg::T_TEXT:
+        return new DLIB::Arg(string(r.value),static_cast<DLIB::Arg::T_Type>(r.type));
+    case DLIB::Arg::T_COMPLEX:
+        return new DLIB::Arg(arglist(r.value,elimit,alimit));
+    case DLIB::Arg::T_EXPR:
+        return new DLIB::Arg(expr(r.value,elimit,alimit));
+    case DLIB::Arg::T_BIT_EXPR:
+        return new DLIB::Arg(bitexpr(r.value));
+    default:
+        file.fail();
+        return 0;
+    }
+}
+
+DLIB::ArgList *cache_reader::arglist(const uint32_t x,const uint32_t elimit,const uint32_t alimit)
+{
+    DLIB::ArgList *l = new DLIB::ArgList();
+
+    // A complex argument is never left without a list, even a bad one
+    if (!below(x,alimit) || !valid(x,S_ARGLISTS)) {
+        return l;
+    }
+    const cache_arglist &r = section<cache_arglist>(S_ARGLISTS)[x];
+
+    if (valid(r.first_arg,S_ARGS,r.nargs)) {
+        for (uint32_t a=0; a<r.nargs && file.is_ok(); ++a) {
+            l->push_back(arg(r.first_arg + a,elimit,x));
+        }
+    }
+    return l;
+}
+
+DLIB::Expr *cache_reader::expr(const uint32_t x,const uint32_t elimit,const uint32_t alimit)
+{
+    if (!below(x,elimit) || !valid(x,S_EXPRS)) {
+        return 0;
+    }
+    const cache_expr        &r  = section<cache_expr>(S_EXPRS)[x];
+    const DLIB::Expr::T_Type op = static_cast<DLIB::Expr::T_Type>(r.type);
+    DLIB::Expr              *ae = 0;
+    DLIB::Expr              *be = 0;
+    DLIB::Arg               *aa = 0;
+    DLIB::Arg               *ba = 0;
+
+    if (r.first != none) {
+        if (r.flags & E_FIRST_EXPR) {
+            ae = expr(r.first,x,alimit);
+        } else {
+            aa = arg(r.first,x,alimit);
+        }
+    }
+    if (r.second != none) {
+        if (r.flags & E_SECOND_EXPR) {
+            be = expr(r.second,x,alimit);
+        } else {
+            ba = arg(r.second,x,alimit);
+        }
+    }
+    if (r.type > DLIB::Expr::T_DIV || (!(r.flags & E_FIRST_EXPR) && (r.flags & E_SECOND_EXPR))) {
+        // No such expression is ever built by the parser
+        file.fail();
+        delete ae;
+        delete aa;
+        delete be;
+        delete ba;
+        return 0;
+    }
+    if (r.flags & E_FIRST_EXPR) {
+        return (r.flags & E_SECOND_EXPR) ? new DLIB::Expr(ae,op,be) : new DLIB::Expr(ae,op,ba);
+    }
+    return new DLIB::Expr(aa,op,ba);
+}
+
+DLIB::BitExpr *cache_reader::bitexpr(const uint32_t x)
+{
+    if (!valid(x,S_BITEXPRS)) {
+        return 0;
+    }
+    const cache_bitexpr &r = section<cache_bitexpr>(S_BITEXPRS)[x];
+
+    switch (r.type) {
+    case DLIB::BitExpr::T_INDEX: return new DLIB::BitExpr(string(r.name),r.first);
+    case DLIB::BitExpr::T_SLICE: return new DLIB::BitExpr(string(r.name),r.first,r.second);
+    default:
+        file.fail();
+        return 0;
+    }
+}
+
+DLIB::Attr *cache_reader::attr(const cache_attr &r)
+{
+    const char *name = string(r.name);
+    float       f;
+
+    switch (r.arg.type) {
+    case DLIB::Arg::T_NUMBER:
+        memcpy(&f,&r.arg.value,sizeof(f));
+        return new DLIB::Attr(name,f);
+    case DLIB::Arg::T_KEYWORD:
+    case DLIB::Arg::T_TEXT:
+        return new DLIB::Attr(name,string(r.arg.value),static_cast<DLIB::Arg::T_Type>(r.arg.type));
+    case DLIB::Arg::T_COMPLEX:
+        return new DLIB::Attr(name,arglist(r.arg.value,none,none));
+    case DLIB::Arg::T_EXPR:
+        return new DLIB::Attr(name,expr(r.arg.value,none,none));
+    case DLIB::Arg::T_BIT_EXPR:
+        return new DLIB::Attr(name,bitexpr(r.arg.value));
+    default:
+        file.fail();
+        return 0;
+    }
+}
+
+// Subgroups always follow their parent, which bounds the recursion
+DLIB::Group *cache_reader::group(const uint32_t x)
+{
+    const cache_group   &r    = section<cache_group>(S_GROUPS)[x];
+    const char          *name = string(r.name);
+    DLIB::ArgList       *args = (r.args != none) ? arglist(r.args,none,none) : 0;
+    list<DLIB::Object*> *objs = new list<DLIB::Object*>();
+
+    if (valid(r.first_attr,S_ATTRS,r.nattrs)) {
+        const cache_attr *attrs = section<cache_attr>(S_ATTRS) + r.first_attr;
+
+        for (uint32_t a=0; a<r.nattrs && file.is_ok(); ++a) {
+            DLIB::Attr *at = attr(attrs[a]);
+
+            if (at) {
+                objs->push_back(at);
+            }
+        }
+    }
+    if (r.ngroups && below(x,r.first_group) && valid(r.first_group,S_GROUPS,r.ngroups)) {
+        for (uint32_t g=0; g<r.ngroups && file.is_ok(); ++g) {
+            objs->push_back(group(r.first_group + g));
+        }
+    }
+    return new DLIB::Group(name,args,objs);
+}
+
+// Only the size is compared when the modification time is the same, the
+// content is hashed otherwise (e.g. a fresh checkout of the same file)
+static bool is_current(const cache_source *h,const char *filename)
+{
+    cache_source id;
+    uint32_t     hash;
+
+    if (!get_source_id(filename,&id) || id.size != h->size) {
+        return false;
+    }
+    if (id.mtime == h->mtime && id.mtime_ns == h->mtime_ns) {
+        return true;
+    }
+    return get_source_hash(filename,&hash) && hash == h->hash;
+}
+
+DLIB::Group *DLIB::load_lib_cache(const char *filename,const char *cachefile)
+{
+    const string path = default_cache(filename,cachefile);
+    cache_reader r;
+
+    if (!filename) {
+        return 0;
+    }
+    // A missing, older or foreign cache is silently ignored
+    switch (r.file.open(path.c_str(),cache_magic,cache_version,S_COUNT,record_size,sizeof(cache_source))) {
+    case SectionReader::R_OK:
+        break;
+    case SectionReader::R_CORRUPTED:
+        printf("LIB-006: %s is corrupted\n",path.c_str());
+        return 0;
+    default:
+        return 0;
+    }
+    if (!is_current(static_cast<const cache_source*>(r.file.get_extra()),filename)) {
+        return 0;
+    }
+    if (!r.file.count(S_GROUPS)) {
+        printf("LIB-006: %s is corrupted\n",path.c_str());
+        return 0;
+    }
+
+    r.strings.resize(r.file.get_string_count());
+    for (size_t x=0; x<r.strings.size(); ++x) {
+        const char *s = r.file.string(static_cast<uint32_t>(x));
+
+        r.strings[x] = DLIB_LEXEMES->get(s,strlen(s));
+    }
+
+    Group *g = r.group(0);
+
+    if (!r.file.is_ok()) {
+        printf("LIB-006: %s is corrupted\n",path.c_str());
+        delete g;
+        return 0;
+    }
+    return g;
+}
+
+pair<bool,DLIB::Group*> DLIB::parse_lib_file_cached(const char *filename,const char *cachefile)
+{
+    Group *g = load_lib_cache(filename,cachefile);
+
+    if (g) {
+        return make_pair(true,g);
+    }
+    pair<bool,Group*> p = parse_lib_file(filename);
+
+    if (filename && p.first && p.second) {
+        save_lib_cache(p.second,filename,cachefile);
+    }
+    return p;
+}
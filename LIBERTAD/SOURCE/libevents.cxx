@@ -0,0 +1,166 @@
+// .LIB reader
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "libobjects.hxx"
+#include "libparser.hxx"
+#include "LexemeTable.hxx"
+#include "MappedFile.hxx"
+
+using namespace std;
+
+// The grammar raises the events from its actions: the groups and the
+// attributes are given to the handler and deleted instead of being kept.
+// Each group on the path is skipped, traversed (it leads to a group
+// selected by a filter) or selected. The body of a skipped group is jumped
+// over by the scanner before any of it is parsed. Attribute values point
+// into the lexeme table of the parse, which is replaced every
+// swap_lexemes lexemes so that the memory doesn't grow with the file. The
+// previous table is kept until the next swap: the lookahead token of the
+// parser may still point into it.
+
+enum {S_SKIPPED,S_TRAVERSED,S_SELECTED};
+enum {M_NONE,M_PREFIX,M_FULL};
+
+static const size_t swap_lexemes = 64 * 1024;
+static const char   STAR_STAR[]  = "**";
+
+// How a path matches the components of a filter from f and p on
+static int match(const vector<const char*> &filter,const size_t f,const DLIB::GroupPath &path,const size_t p)
+{
+    if (p == path.size()) {
+        for (size_t x=f; x<filter.size(); ++x) {
+            if (filter[x] != STAR_STAR) {
+                return M_PREFIX;
+            }
+        }
+        return M_FULL;
+    }
+    if (f == filter.size()) {
+        return M_NONE;
+    }
+    if (filter[f] == STAR_STAR) {
+        const int m = match(filter,f + 1,path,p);
+
+        return (m == M_FULL) ? m : max(m,match(filter,f,path,p + 1));
+    }
+    if (filter[f] && filter[f] != path[p]) {
+        return M_NONE;
+    }
+    return match(filter,f + 1,path,p + 1);
+}
+
+DLIB::EventParse::EventParse(EventHandler *h,const vector<const char*> &f):
+    handler(h),previous(0)
+{
+    for (size_t x=0; x<f.size(); ++x) {
+        vector<const char*> names;
+        const char         *s = f[x];
+
+        while (*s) {
+            const char  *e = strchr(s,'/');
+            const size_t n = e ? e - s : strlen(s);
+
+            if (n == 1 && *s == '*') {
+                names.push_back(0);
+            } else if (n == 2 && s[0] == '*' && s[1] == '*') {
+                names.push_back(STAR_STAR);
+            } else if (n) {
+                names.push_back(DLIB_LEXEMES->get(s,n,false));
+            }
+            s += n + (e != 0);
+        }
+        filters.push_back(names);
+    }
+}
+
+DLIB::EventParse::~EventParse()
+{
+    delete previous;
+}
+
+void DLIB::EventParse::begin_group(ParseContext *ctx,const char *name,const ArgList *args)
+{
+    int state = states.empty() ? S_TRAVERSED : states.back();
+
+    path.push_back(DLIB_LEXEMES->get(name,false));
+    if (state != S_SELECTED) {
+        int best = filters.empty() ? M_FULL : M_NONE;
+
+        for (size_t x=0; x<filters.size() && best != M_FULL; ++x) {
+            best = max(best,match(filters[x],0,path,0));
+        }
+        state = (best == M_FULL) ? S_SELECTED : ((best == M_PREFIX) ? S_TRAVERSED : S_SKIPPED);
+    }
+    states.push_back(state);
+    if (state == S_SKIPPED && ctx->text) {
+        ctx->text = skip_group_body(ctx->text,ctx->end,&ctx->line);
+    } else if (state == S_SKIPPED) {
+        ctx->skip = 1;
+    } else {
+        handler->begin_group(path,args);
+    }
+}
+
+DLIB::Group *DLIB::EventParse::end_group(ParseContext *ctx,const ArgList *args,list<Object*> *items)
+{
+    if (states.back() != S_SKIPPED) {
+        handler->end_group(path);
+    }
+    states.pop_back();
+    path.pop_back();
+    if (args) {
+        for (ArgList::const_iterator x=args->begin(); x!=args->end(); ++x) {
+            delete *x;
+        }
+        delete args;
+    }
+    delete items;
+    return 0;
+}
+
+DLIB::Attr *DLIB::EventParse::attribute(ParseContext *ctx,Attr *a)
+{
+    if (states.back() == S_SELECTED) {
+        handler->attribute(path,a);
+    }
+    delete a;
+    if (ctx->lexemes->size() >= swap_lexemes) {
+        delete previous;
+        previous     = ctx->lexemes;
+        ctx->lexemes = new LexemeTable();
+    }
+    return 0;
+}
+
+bool DLIB::parse_lib_file_events(const char *filename,EventHandler *handler,const vector<const char*> &filters)
+{
+    MappedFile   m;
+    EventParse   events(handler,filters);
+    ParseContext ctx;
+    bool         isok;
+
+    ctx.lexemes = new LexemeTable();
+    ctx.events  = &events;
+    if (filename && m.open(filename,2)) {
+        isok = parse_lib_buffer(&ctx,m.data(),m.size());
+    } else {
+        FILE *f = filename ? fopen(filename,"r") : stdin;
+
+        if (!f) {
+            printf("LIB-004: Cannot open %s\n",filename);
+            delete ctx.lexemes;
+            return false;
+        }
+        isok = parse_lib_stream(&ctx,f);
+        if (f != stdin) {
+            fclose(f);
+        }
+    }
+    delete ctx.lexemes;
+    return isok;
+}
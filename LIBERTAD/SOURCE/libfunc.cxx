@@ -0,0 +1,277 @@
+// .LIB reader
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "LexemeTable.hxx"
+#include "libobjects.hxx"
+
+using namespace std;
+
+extern LexemeTable *DLIB_LEXEMES;
+
+// An expression is compiled to a postfix program over 64 bit words, each
+// bit is one input pattern. A function of up to 6 inputs is then run once
+// on the patterns of the truth table, whose bit k has input i set to bit i
+// of k, and only its table is kept. The table is evaluated by a tree of
+// multiplexers, one level per input.
+
+enum {OP_INPUT,OP_ZERO,OP_ONE,OP_NOT,OP_AND,OP_OR,OP_XOR};
+
+static const unsigned max_table_inputs = 6;
+static const unsigned max_equivalence_inputs = 24;
+
+// Input i of the truth table
+static const uint64_t TABLE_INPUTS[max_table_inputs] = {
+    0xAAAAAAAAAAAAAAAAULL,0xCCCCCCCCCCCCCCCCULL,0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL,0xFFFF0000FFFF0000ULL,0xFFFFFFFF00000000ULL
+};
+
+
+//-----------------------------------------------------------------------------
+// Class Function
+//-----------------------------------------------------------------------------
+DLIB::Function::Function(const Expr *e):
+    _table(0),_depth(0),_isok(e != 0)
+{
+    if (e) {
+        compile(e);
+    }
+    if (!_isok) {
+        _code.clear();
+        return;
+    }
+    int depth = 0;
+
+    for (size_t x=0; x<_code.size(); ++x) {
+        const unsigned op = _code[x] & 0xff;
+
+        depth += (op <= OP_ONE) ? 1 : ((op == OP_NOT) ? 0 : -1);
+        _depth = (depth > int(_depth)) ? depth : _depth;
+    }
+    if (_inputs.size() <= max_table_inputs) {
+        vector<uint64_t> stack(_depth);
+
+        run(TABLE_INPUTS,stack.data());
+        _table = stack[0];
+        _code.clear();
+    }
+}
+
+void DLIB::Function::compile(const Expr *e)
+{
+    if (e->is_first_expr()) {
+        compile(e->get_first_expr());
+    } else {
+        compile(e->get_first_arg());
+    }
+    switch (e->get_type()) {
+    case Expr::T_BUF:
+        return;
+    case Expr::T_NOT:
+        _code.push_back(OP_NOT);
+        return;
+    case Expr::T_AND:
+    case Expr::T_OR:
+    case Expr::T_XOR:
+        break;
+    default:
+        _isok = false;
+        return;
+    }
+    if (e->is_second_expr()) {
+        compile(e->get_second_expr());
+    } else {
+        compile(e->get_second_arg());
+    }
+    _code.push_back(e->get_type() == Expr::T_AND ? OP_AND : (e->get_type() == Expr::T_OR ? OP_OR : OP_XOR));
+}
+
+void DLIB::Function::compile(const Arg *a)
+{
+    const char *name = 0;
+    string      bit;
+
+    switch (a ? a->get_type() : Arg::T_UNKNOWN) {
+    case Arg::T_KEYWORD:
+        name = a->get_keyword();
+        break;
+    case Arg::T_TEXT: {
+        // 0, 1, 1'b0 or 1'b1
+        const char  *t = a->get_text();
+        const size_t n = strlen(t);
+
+        if ((n == 1 || (n == 4 && !strncmp(t,"1'b",3))) && (t[n-1] == '0' || t[n-1] == '1')) {
+            _code.push_back(t[n-1] == '1' ? OP_ONE : OP_ZERO);
+        } else {
+            _isok = false;
+        }
+        return;
+    }
+    case Arg::T_BIT_EXPR:
+        if (a->get_bit_expr()->get_type() == BitExpr::T_INDEX) {
+            bit  = string(a->get_bit_expr()->get_name()) + "[" + to_string(a->get_bit_expr()->get_index()) + "]";
+            name = DLIB_LEXEMES->get(bit.c_str(),bit.size());
+            break;
+        }
+        // fall through, a slice is not a single input
+    default:
+        _isok = false;
+        return;
+    }
+    int i = find_input(name);
+
+    if (i < 0) {
+        i = _inputs.size();
+        _inputs.push_back(name);
+    }
+    _code.push_back(OP_INPUT | (i << 8));
+}
+
+void DLIB::Function::run(const uint64_t *inputs,uint64_t *stack) const
+{
+    uint64_t *sp = stack;
+
+    for (vector<uint32_t>::const_iterator x=_code.begin(); x!=_code.end(); ++x) {
+        switch (*x & 0xff) {
+        case OP_INPUT: *sp++ = inputs[*x >> 8];  break;
+        case OP_ZERO:  *sp++ = 0;                break;
+        case OP_ONE:   *sp++ = ~uint64_t(0);     break;
+        case OP_NOT:   sp[-1] = ~sp[-1];         break;
+        case OP_AND:   --sp; sp[-1] &= sp[0];    break;
+        case OP_OR:    --sp; sp[-1] |= sp[0];    break;
+        case OP_XOR:   --sp; sp[-1] ^= sp[0];    break;
+        }
+    }
+}
+
+unsigned     DLIB::Function::get_inputs()                const {return _inputs.size();}
+const char  *DLIB::Function::get_input(const unsigned n) const {return n < _inputs.size() ? _inputs[n] : 0;}
+bool         DLIB::Function::has_truth_table()           const {return _inputs.size() <= max_table_inputs;}
+uint64_t     DLIB::Function::get_truth_table()           const {return _table;}
+bool         DLIB::Function::is_valid()                  const {return _isok;}
+
+int DLIB::Function::find_input(const char *name) const
+{
+    for (size_t x=0; x<_inputs.size(); ++x) {
+        if (!strcmp(_inputs[x],name)) {
+            return x;
+        }
+    }
+    return -1;
+}
+
+uint64_t DLIB::Function::evaluate(const uint64_t *inputs) const
+{
+    if (has_truth_table()) {
+        // w[k] is the value of the function when the inputs not yet
+        // selected have the values of the bits of k
+        uint64_t w[1 << max_table_inputs];
+
+        for (unsigned k=0; k<(1u << _inputs.size()); ++k) {
+            w[k] = -((_table >> k) & 1);
+        }
+        for (int i=_inputs.size()-1; i>=0; --i) {
+            const uint64_t sel = inputs[i];
+
+            for (unsigned k=0; k<(1u << i); ++k) {
+                w[k] = (w[k] & ~sel) | (w[k + (1u << i)] & sel);
+            }
+        }
+        return w[0];
+    }
+    uint64_t stack[64];
+
+    if (_depth > 64) {
+        vector<uint64_t> deep(_depth);
+
+        run(inputs,deep.data());
+        return deep[0];
+    }
+    run(inputs,stack);
+    return stack[0];
+}
+
+bool DLIB::Function::is_equivalent(const Function *f) const
+{
+    vector<const char*> names(_inputs);
+    vector<unsigned>    map(f->_inputs.size());
+
+    for (size_t x=0; x<f->_inputs.size(); ++x) {
+        const int i = find_input(f->_inputs[x]);
+
+        map[x] = (i >= 0) ? i : names.size();
+        if (i < 0) {
+            names.push_back(f->_inputs[x]);
+        }
+    }
+    const unsigned n = names.size();
+
+    if (n > max_equivalence_inputs) {
+        return false;
+    }
+    // Past 6 inputs, each word holds the 64 patterns of the first 6
+    const size_t     words = (n <= max_table_inputs) ? 1 : size_t(1) << (n - max_table_inputs);
+    const uint64_t   mask  = (n < max_table_inputs) ? (uint64_t(1) << (1u << n)) - 1 : ~uint64_t(0);
+    vector<uint64_t> a(n + 1),b(map.size() + 1);
+
+    // The inputs of this function come first in names
+    for (size_t w=0; w<words; ++w) {
+        for (unsigned i=0; i<n; ++i) {
+            a[i] = (i < max_table_inputs) ? TABLE_INPUTS[i] : -uint64_t((w >> (i - max_table_inputs)) & 1);
+        }
+        for (size_t x=0; x<map.size(); ++x) {
+            b[x] = a[map[x]];
+        }
+        if ((evaluate(a.data()) ^ f->evaluate(b.data())) & mask) {
+            return false;
+        }
+    }
+    return true;
+}
+
+pair<bool,DLIB::Function*> DLIB::compile_function_string(const char *expr)
+{
+    pair<bool,Expr*> e = parse_expression_string(expr);
+    Function        *f = 0;
+
+    if (e.first && e.second) {
+        f = new Function(e.second);
+        if (!f->is_valid()) {
+            printf("LIB-008: unsupported logic expression '%s'\n",expr);
+            delete f;
+            f = 0;
+        }
+    }
+    delete e.second;
+    return make_pair(f != 0,f);
+}
+
+
+//-----------------------------------------------------------------------------
+// Class Attr
+//-----------------------------------------------------------------------------
+const DLIB::Function *DLIB::Attr::get_function() const
+{
+    Function *f = _function.load(memory_order_acquire);
+
+    if (!f) {
+        const char *text     = get_text() ? get_text() : get_keyword();
+        Function   *expected = 0;
+
+        if (text) {
+            pair<bool,Function*> c = compile_function_string(text);
+
+            f = c.second;
+        }
+        f = f ? f : new Function(0);
+        if (!_function.compare_exchange_strong(expected,f,memory_order_acq_rel)) {
+            delete f;
+            f = expected;
+        }
+    }
+    return f->is_valid() ? f : 0;
+}
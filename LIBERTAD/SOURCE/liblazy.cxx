@@ -0,0 +1,134 @@
+// .LIB reader
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <vector>
+#include <mutex>
+#include "libobjects.hxx"
+#include "liblazy.hxx"
+#include "LexemeTable.hxx"
+
+using namespace std;
+
+extern LexemeTable *DLIB_LEXEMES;
+
+// A lazy library is parsed from a copy of the file without its cells (see
+// scan_top_groups()). A cell is parsed from the mapped file, on its own,
+// when first needed. Once they are all parsed they are inserted among the
+// other subgroups of the library, in file order.
+
+//-----------------------------------------------------------------------------
+// Class Group::lazy
+//-----------------------------------------------------------------------------
+
+DLIB::Group::lazy::~lazy()
+{
+    if (!done) {
+        for (size_t x=0; x<cells.size(); ++x) {
+            delete cells[x].group;
+        }
+    }
+}
+
+void DLIB::Group::lazy::parse(cell &c)
+{
+    bool isok;
+
+    c.group  = parse_top_group(file.data(),c.top,&isok);
+    c.parsed = true;
+    if (!isok || (c.group && c.group->get_name() != cell_name)) {
+        delete c.group;
+        c.group = 0;
+    }
+}
+
+const DLIB::Group *DLIB::Group::lazy::find(const char *name)
+{
+    const unsigned x = names.find(name);
+
+    if (x == NameIndex::npos) {
+        return 0;
+    }
+    if (!done.load(memory_order_acquire)) {
+        lock_guard<mutex> g(lock);
+
+        if (!cells[x].parsed) {
+            parse(cells[x]);
+        }
+    }
+    return cells[x].group;
+}
+
+
+//-----------------------------------------------------------------------------
+// Class Group
+//-----------------------------------------------------------------------------
+
+void DLIB::Group::parse_cells() const
+{
+    if (!_lazy || _lazy->done.load(memory_order_acquire)) {
+        return;
+    }
+    lock_guard<mutex> g(_lazy->lock);
+
+    if (_lazy->done.load(memory_order_relaxed)) {
+        return;
+    }
+    GroupList::iterator i   = _groups.begin();
+    size_t              pos = 0;
+
+    for (size_t x=0; x<_lazy->cells.size(); ++x) {
+        lazy::cell &c = _lazy->cells[x];
+
+        if (!c.parsed) {
+            _lazy->parse(c);
+        }
+        while (pos < c.position && i != _groups.end()) {
+            ++i;
+            ++pos;
+        }
+        if (c.group) {
+            _groups.insert(i,c.group);
+        }
+        ++pos;
+    }
+    _lazy->done.store(true,memory_order_release);
+}
+
+pair<bool,DLIB::Group*> DLIB::parse_lib_file_lazy(const char *filename)
+{
+    Group::lazy     *l = new Group::lazy();
+    vector<TopGroup> tops;
+
+    if (!filename || !l->file.open(filename) || !scan_top_groups(l->file.data(),l->file.size(),&tops)) {
+        delete l;
+        return parse_lib_file(filename);
+    }
+    for (size_t x=0; x<tops.size(); ++x) {
+        if (tops[x].cell) {
+            Group::lazy::cell c = {tops[x],x,0,false};
+
+            l->cells.push_back(c);
+        }
+    }
+    if (l->cells.empty()) {
+        delete l;
+        return parse_lib_file(filename);
+    }
+    vector<char> skeleton = strip_top_groups(l->file.data(),l->file.size(),tops,true);
+    ParseContext ctx;
+    const bool   isok     = parse_lib_buffer(&ctx,skeleton.data(),skeleton.size() - 2);
+    Group       *g        = ctx.top;
+
+    if (!g) {
+        delete l;
+        return make_pair(false,g);
+    }
+    l->cell_name = DLIB_LEXEMES->get("cell",false);
+    l->names.reserve(l->cells.size());
+    for (size_t x=0; x<l->cells.size(); ++x) {
+        l->names.insert(l->cells[x].top.cell,static_cast<unsigned>(x));
+    }
+    g->_lazy = l;
+    return make_pair(isok,g);
+}
@@ -0,0 +1,42 @@
+// .LIB reader
+// Author: David Berthelot
+//
+// Cells of a library parsed on demand (internal header)
+
+#ifndef DLIB_LAZY_H
+#define DLIB_LAZY_H
+
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+#include <mutex>
+#include "libobjects.hxx"
+#include "libparser.hxx"
+#include "MappedFile.hxx"
+#include "NameIndex.hxx"
+
+/// @internal The top level cell groups of a library, located by a scan of
+/// the file and parsed from the mapped file when first needed
+struct DLIB::Group::lazy {
+    struct cell {
+        TopGroup     top;
+        size_t       position;      // Among the subgroups of the library
+        Group       *group;         // 0 until parsed, or when the cell has syntax errors
+        bool         parsed;
+    };
+
+    MappedFile       file;
+    vector<cell>     cells;         // In file order
+    NameIndex        names;         // Cell name -> index in cells
+    const char      *cell_name;     // Lexeme of "cell"
+    mutex            lock;          // Held while cells are parsed
+    atomic<bool>     done;          // All cells are parsed and owned by the library
+
+    lazy(): cell_name(0),done(false) {}
+    ~lazy();
+
+    void             parse(cell &c);  // With lock held
+    const Group     *find(const char *name);
+};
+
+#endif
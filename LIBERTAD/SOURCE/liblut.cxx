@@ -0,0 +1,178 @@
+// .LIB reader
+// Author: David Berthelot
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "libobjects.hxx"
+
+using namespace std;
+
+// Tables are written as quoted lists of numbers, one string per row of
+// values: values ("1, 2", "3, 4"). The numbers are read in place with
+// strtof, commas and line continuations are separators.
+
+static inline bool is_separator(const char c)
+{
+    return c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\\';
+}
+
+static bool decode_text(const char *text,vector<float> *v)
+{
+    for (;;) {
+        while (is_separator(*text)) {
+            ++text;
+        }
+        if (!*text) {
+            return true;
+        }
+        char *end;
+
+        v->push_back(strtof(text,&end));
+        if (end == text) {
+            return false;
+        }
+        text = end;
+    }
+}
+
+static bool decode_arg(const DLIB::Arg *a,vector<float> *v)
+{
+    switch (a->get_type()) {
+    case DLIB::Arg::T_NUMBER:
+        v->push_back(a->get_number());
+        return true;
+    case DLIB::Arg::T_TEXT:
+        return decode_text(a->get_text(),v);
+    case DLIB::Arg::T_COMPLEX:
+        for (DLIB::ArgList::const_iterator x=a->get_complex()->begin(); x!=a->get_complex()->end(); ++x) {
+            if (!decode_arg(*x,v)) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+// The attribute of the table, or else of its template
+static const DLIB::Attr *find_attr(const DLIB::Group *table,const DLIB::Group *tmpl,const char *name)
+{
+    const DLIB::Attr *a = table->find_attr(name);
+
+    return (a || !tmpl) ? a : tmpl->find_attr(name);
+}
+
+// Segment of index containing v (the first or last one outside of index)
+// and the position of v in it
+static inline void locate(const vector<float> &index,const float v,size_t *i,float *t)
+{
+    const size_t n = index.size();
+
+    if (n < 2) {
+        *i = 0;
+        *t = 0;
+        return;
+    }
+    size_t x = upper_bound(index.begin(),index.end(),v) - index.begin();
+
+    x  = (x == 0) ? 0 : ((x >= n) ? n-2 : x-1);
+    *i = x;
+    *t = (index[x+1] != index[x]) ? (v - index[x]) / (index[x+1] - index[x]) : 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Class LookupTable
+//-----------------------------------------------------------------------------
+DLIB::LookupTable::LookupTable(const Group *table,const Group *library):
+    _template(0),_dims(0),_isok(false)
+{
+    static const char *templates[] = {"lu_table_template","power_lut_template"};
+    static const char *indexes[]   = {"index_1","index_2"};
+    static const char *variables[] = {"variable_1","variable_2"};
+    const Group       *tmpl        = 0;
+
+    _variables[0] = _variables[1] = 0;
+    _template     = table->get_unique_name();
+    // scalar is predefined, it has no group in the library
+    if (_template && !strcmp(_template,"scalar")) {
+        library = 0;
+    }
+    for (size_t x=0; _template && library && !tmpl && x<sizeof(templates)/sizeof(*templates); ++x) {
+        tmpl = library->find_group(templates[x],_template);
+    }
+    if (find_attr(table,tmpl,"index_3")) {
+        return;
+    }
+    size_t count = 1;
+
+    for (unsigned x=0; x<2; ++x) {
+        const Attr *index = find_attr(table,tmpl,indexes[x]);
+        const Attr *var   = tmpl ? tmpl->find_attr(variables[x]) : 0;
+
+        if (var) {
+            _variables[x] = var->get_string();
+        }
+        if (!index) {
+            break;
+        }
+        if (!decode_arg(index,&_indexes[x]) || _indexes[x].empty()) {
+            return;
+        }
+        count *= _indexes[x].size();
+        _dims  = x+1;
+    }
+    const Attr *values = table->find_attr("values");
+
+    _values.reserve(count);
+    _isok = values && decode_arg(values,&_values) && _values.size() == count;
+}
+
+const char  *DLIB::LookupTable::get_template()               const {return _template;}
+unsigned     DLIB::LookupTable::get_dimensions()             const {return _dims;}
+const char  *DLIB::LookupTable::get_variable(const unsigned n) const {return (n == 1 || n == 2) ? _variables[n-1] : 0;}
+unsigned     DLIB::LookupTable::get_size(const unsigned n)     const {return (n == 1 || n == 2) && !_indexes[n-1].empty() ? _indexes[n-1].size() : 1;}
+const float *DLIB::LookupTable::get_index(const unsigned n)    const {return (n == 1 || n == 2) && !_indexes[n-1].empty() ? _indexes[n-1].data() : 0;}
+const float *DLIB::LookupTable::get_values()                 const {return _values.data();}
+bool         DLIB::LookupTable::is_valid()                   const {return _isok;}
+
+float DLIB::LookupTable::interpolate(const float x,const float y) const
+{
+    size_t i,j;
+    float  tx,ty;
+
+    locate(_indexes[0],x,&i,&tx);
+    locate(_indexes[1],y,&j,&ty);
+
+    const size_t n2 = _indexes[1].empty() ? 1 : _indexes[1].size();
+    const size_t i1 = (_indexes[0].size() > 1) ? i+1 : i;
+    const size_t j1 = (n2 > 1) ? j+1 : j;
+    const float  a  = _values[i  * n2 + j] + (_values[i  * n2 + j1] - _values[i  * n2 + j]) * ty;
+    const float  b  = _values[i1 * n2 + j] + (_values[i1 * n2 + j1] - _values[i1 * n2 + j]) * ty;
+
+    return a + (b - a) * tx;
+}
+
+
+//-----------------------------------------------------------------------------
+// Class Group
+//-----------------------------------------------------------------------------
+const DLIB::LookupTable *DLIB::Group::get_lookup_table(const Group *library) const
+{
+    LookupTable *t = _table.load(memory_order_acquire);
+
+    if (!t) {
+        LookupTable *expected = 0;
+
+        t = new LookupTable(this,library);
+        if (!_table.compare_exchange_strong(expected,t,memory_order_acq_rel)) {
+            delete t;
+            t = expected;
+        }
+    }
+    return t->is_valid() ? t : 0;
+}
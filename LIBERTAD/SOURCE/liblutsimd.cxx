@@ -0,0 +1,112 @@
+// .LIB reader
+// Author: David Berthelot
+
+#include <stddef.h>
+#include <vector>
+#include "libobjects.hxx"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DLIB_LUT_AVX2
+#endif
+
+using namespace std;
+
+// Batched interpolation. The segment of an index that contains a point is
+// the number of inner index values not above it, so it is found for 8
+// points at once by comparing them with each inner value of the index,
+// without branches (tables rarely have more than 10 values per index).
+// The corners are then gathered and interpolated as in interpolate(), in
+// the same order of operations, so the results are identical. The AVX2
+// code is compiled for that target only and chosen when the processor
+// supports it, the other points go through interpolate().
+
+#ifdef DLIB_LUT_AVX2
+__attribute__((target("avx2")))
+static inline void locate8(const float *index,const int n,const __m256 v,__m256i *i,__m256i *i1,__m256 *t)
+{
+    if (n < 2) {
+        *i  = _mm256_setzero_si256();
+        *i1 = *i;
+        *t  = _mm256_setzero_ps();
+        return;
+    }
+    __m256i c = _mm256_setzero_si256();
+
+    for (int k=1; k<n-1; ++k) {
+        // The comparison is -1 in the lanes where index[k] <= v
+        c = _mm256_sub_epi32(c,_mm256_castps_si256(_mm256_cmp_ps(_mm256_set1_ps(index[k]),v,_CMP_LE_OQ)));
+    }
+    const __m256i c1 = _mm256_add_epi32(c,_mm256_set1_epi32(1));
+    const __m256  lo = _mm256_i32gather_ps(index,c,4);
+    const __m256  d  = _mm256_sub_ps(_mm256_i32gather_ps(index,c1,4),lo);
+    const __m256  q  = _mm256_div_ps(_mm256_sub_ps(v,lo),d);
+
+    *i  = c;
+    *i1 = c1;
+    *t  = _mm256_blendv_ps(q,_mm256_setzero_ps(),_mm256_cmp_ps(d,_mm256_setzero_ps(),_CMP_EQ_OQ));
+}
+
+// Returns the number of points done, a multiple of 8
+__attribute__((target("avx2")))
+static size_t interpolate_avx2(const float *index1,const int n1,const float *index2,const int n2,const float *values,
+                               const float *x,const float *y,float *out,const size_t n)
+{
+    const __m256i stride = _mm256_set1_epi32(n2 < 2 ? 1 : n2);
+    size_t        k      = 0;
+
+    for (; k+8 <= n; k+=8) {
+        __m256i i,i1,j,j1;
+        __m256  tx,ty;
+
+        locate8(index1,n1,_mm256_loadu_ps(x + k),&i,&i1,&tx);
+        locate8(index2,n2,y ? _mm256_loadu_ps(y + k) : _mm256_setzero_ps(),&j,&j1,&ty);
+
+        const __m256i r   = _mm256_mullo_epi32(i,stride);
+        const __m256i r1  = _mm256_mullo_epi32(i1,stride);
+        const __m256  v00 = _mm256_i32gather_ps(values,_mm256_add_epi32(r,j),4);
+        const __m256  v01 = _mm256_i32gather_ps(values,_mm256_add_epi32(r,j1),4);
+        const __m256  v10 = _mm256_i32gather_ps(values,_mm256_add_epi32(r1,j),4);
+        const __m256  v11 = _mm256_i32gather_ps(values,_mm256_add_epi32(r1,j1),4);
+        const __m256  a   = _mm256_add_ps(v00,_mm256_mul_ps(_mm256_sub_ps(v01,v00),ty));
+        const __m256  b   = _mm256_add_ps(v10,_mm256_mul_ps(_mm256_sub_ps(v11,v10),ty));
+
+        _mm256_storeu_ps(out + k,_mm256_add_ps(a,_mm256_mul_ps(_mm256_sub_ps(b,a),tx)));
+    }
+    return k;
+}
+
+static bool has_avx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+
+    return avx2;
+}
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Class LookupTable
+//-----------------------------------------------------------------------------
+void DLIB::LookupTable::interpolate(const float *x,const float *y,float *out,const size_t n) const
+{
+    size_t k = 0;
+
+#ifdef DLIB_LUT_AVX2
+    if (has_avx2()) {
+        k = interpolate_avx2(_indexes[0].data(),_indexes[0].size(),_indexes[1].data(),_indexes[1].size(),_values.data(),x,y,out,n);
+    }
+#endif
+    for (; k<n; ++k) {
+        out[k] = interpolate(x[k],y ? y[k] : 0);
+    }
+}
+
+// The tables of arcs have indexes of their own, evaluating them in lanes
+// would need a gather for each index value, so they are done one by one
+void DLIB::LookupTable::interpolate(const LookupTable *const *tables,const size_t n,const float x,const float y,float *out)
+{
+    for (size_t k=0; k<n; ++k) {
+        out[k] = tables[k]->interpolate(x,y);
+    }
+}
@@ -4,11 +4,18 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <mutex>
 #include <string>
+#include <atomic>
 #include <vector>
 #include "libobjects.hxx"
+#include "libparser.hxx"
+#include "liblazy.hxx"
 #include "LexemeTable.hxx"
-#include "libfile.tab.hxx"
+#include "MappedFile.hxx"
+#include "NameIndex.hxx"
+#include "TextHash.hxx"
 
 using namespace std;
 
@@ -17,29 +24,41 @@ using namespace std;
 // }
 
 int          DLIB_line;
-extern int          libfileparse();
 extern int          libexprparse();
 extern int          libexpr_scan_string(const char *);
-extern FILE *libfilein;
-extern int   libfiledebug;
-static LexemeTable LEXEMES;
+static LexemeTable LEXEMES(true);
 LexemeTable       *DLIB_LEXEMES = &LEXEMES;
-DLIB::Group       *toplib       = 0;
 DLIB::Expr        *DLIB_Parsed_expr = 0;
 
-pair<bool,DLIB::Group*> DLIB::parse_lib_file(const char *filename)
+pair<bool,DLIB::Group*> DLIB::parse_lib_file(const char *filename,const bool use_mmap)
 {
-    libfilein    = filename ? fopen(filename,"r") : stdin;
-    libfiledebug = 0;
-    DLIB_line    = 1;
+    MappedFile   m;
+    ParseContext ctx;
+    bool         isok;
 
-    const bool isok = !libfileparse();
-    
-    return make_pair(isok,toplib);
+    if (use_mmap && filename && m.open(filename,2)) {
+        isok = parse_lib_buffer(&ctx,m.data(),m.size());
+    } else {
+        FILE *f = filename ? fopen(filename,"r") : stdin;
+
+        if (!f) {
+            printf("LIB-004: Cannot open %s\n",filename);
+            return make_pair(false,ctx.top);
+        }
+        isok = parse_lib_stream(&ctx,f);
+        if (f != stdin) {
+            fclose(f);
+        }
+    }
+    return make_pair(isok,ctx.top);
 }
 
+// The expression parser is not reentrant
 pair<bool,DLIB::Expr*> DLIB::parse_expression_string(const char *expr)
 {
+    static mutex      lock;
+    lock_guard<mutex> guard(lock);
+
     DLIB_line        = 0;
     DLIB_Parsed_expr = 0;
 
@@ -77,16 +96,27 @@ const DLIB::Arg *DLIB::ArgList::get_unique_arg() const
     }
 }
 
+// Names of groups and attributes are lexemes folded to lower case, the
+// names looked up are folded while compared so they are never interned
+static inline bool same_name(const char *lexeme,const char *name)
+{
+    for (; *name; ++lexeme,++name) {
+        if (static_cast<unsigned char>(*lexeme) != lower_ascii(*name)) {
+            return false;
+        }
+    }
+    return !*lexeme;
+}
+
 //-----------------------------------------------------------------------------
 // Class GroupList
 //-----------------------------------------------------------------------------
 const vector<const DLIB::Group*> DLIB::GroupList::find_groups(const char *name) const
 {
-    const char           *lname = DLIB_LEXEMES->get(name,false);
-    vector<const Group*>  v;
-    
+    vector<const Group*> v;
+
     for (const_iterator x = begin(); x != end(); ++x) {
-        if ((*x)->get_name() == lname) {
+        if (same_name((*x)->get_name(),name)) {
             v.push_back(*x);
         }
     }
@@ -99,10 +129,8 @@ const vector<const DLIB::Group*> DLIB::GroupList::find_groups(const char *name)
 //-----------------------------------------------------------------------------
 const DLIB::Attr *DLIB::AttrList::find_attr(const char *name) const
 {
-    const char *lname = DLIB_LEXEMES->get(name,false);
-    
     for (const_iterator x = begin(); x != end(); ++x) {
-        if ((*x)->get_name() == lname) {
+        if (same_name((*x)->get_name(),name)) {
             return *x;
         }
     }
@@ -115,32 +143,33 @@ const DLIB::Attr *DLIB::AttrList::find_attr(const char *name) const
 //-----------------------------------------------------------------------------
         
 DLIB::Attr::Attr(const char *name,const char *str,const Arg::T_Type t):
-    Object(name),Arg(str,t)
+    Object(name),Arg(str,t),_function(0)
 {
 }
 
 DLIB::Attr::Attr(const char *name,const float number):
-    Object(name),DLIB::Arg(number)
+    Object(name),DLIB::Arg(number),_function(0)
 {
 }
 
 DLIB::Attr::Attr(const char *name,const ArgList *args):
-    Object(name),DLIB::Arg(args)
+    Object(name),DLIB::Arg(args),_function(0)
 {
 }
 
 DLIB::Attr::Attr(const char *name,const Expr *expr):
-    Object(name),DLIB::Arg(expr)
+    Object(name),DLIB::Arg(expr),_function(0)
 {
 }
 
 DLIB::Attr::Attr(const char *name,const BitExpr *bit_expr):
-    Object(name),DLIB::Arg(bit_expr)
+    Object(name),DLIB::Arg(bit_expr),_function(0)
 {
 }
 
 DLIB::Attr::~Attr()
 {
+    delete _function.load();
 }
 
 
@@ -148,9 +177,112 @@ DLIB::Attr::~Attr()
 // Class Group
 //-----------------------------------------------------------------------------
 
+// The subgroups of a group by name, and by argument among the groups of
+// one name. Few names, attributes or groups of a name are scanned, they
+// are only hashed when there are many of them.
+struct DLIB::Group::index {
+    static const size_t  many = 8;
+
+    vector<const char*>  names;     // Distinct names of the subgroups, in order of first appearance
+    vector<unsigned>     starts;    // The groups named names[i] are groups[starts[i]] to groups[starts[i+1]-1]
+    vector<const Group*> groups;    // In file order for each name
+    NameIndex           *name_ids;  // names -> i, 0 for few names
+    vector<NameIndex*>   args;      // Argument -> position among the groups named names[i], 0 for few groups
+    NameIndex           *attr_ids;  // Attribute name -> first occurrence in attrs, 0 for few attributes
+    vector<const Attr*>  attrs;
+
+    index(const GroupList &gl,const AttrList &al);
+    ~index();
+
+    unsigned find(const char *name) const;  // i of name, NameIndex::npos if absent
+};
+
+DLIB::Group::index::index(const GroupList &gl,const AttrList &al):
+    name_ids(0),attr_ids(0)
+{
+    NameIndex        ids(false);
+    vector<unsigned> of;
+
+    of.reserve(gl.size());
+    for (GroupList::const_iterator x=gl.begin(); x!=gl.end(); ++x) {
+        const unsigned i = ids.insert((*x)->get_name(),static_cast<unsigned>(names.size()));
+
+        if (i == names.size()) {
+            names.push_back((*x)->get_name());
+        }
+        of.push_back(i);
+    }
+    starts.assign(names.size() + 1,0);
+    for (size_t x=0; x<of.size(); ++x) {
+        ++starts[of[x] + 1];
+    }
+    for (size_t x=0; x<names.size(); ++x) {
+        starts[x+1] += starts[x];
+    }
+    vector<unsigned> next(starts.begin(),starts.end() - 1);
+    size_t           k = 0;
+
+    groups.resize(gl.size());
+    for (GroupList::const_iterator x=gl.begin(); x!=gl.end(); ++x,++k) {
+        groups[next[of[k]]++] = *x;
+    }
+    if (names.size() > many) {
+        name_ids = new NameIndex(false);
+        name_ids->reserve(names.size());
+        for (size_t x=0; x<names.size(); ++x) {
+            name_ids->insert(names[x],static_cast<unsigned>(x));
+        }
+    }
+    args.assign(names.size(),static_cast<NameIndex*>(0));
+    for (size_t x=0; x<names.size(); ++x) {
+        if (starts[x+1] - starts[x] > many) {
+            args[x] = new NameIndex();
+            args[x]->reserve(starts[x+1] - starts[x]);
+            for (unsigned p=0; p<starts[x+1]-starts[x]; ++p) {
+                const char *a = groups[starts[x] + p]->get_unique_name();
+
+                if (a) {
+                    args[x]->insert(a,p);
+                }
+            }
+        }
+    }
+    if (al.size() > many) {
+        attr_ids = new NameIndex(false);
+        attr_ids->reserve(al.size());
+        for (AttrList::const_iterator x=al.begin(); x!=al.end(); ++x) {
+            if (attr_ids->insert((*x)->get_name(),static_cast<unsigned>(attrs.size())) == attrs.size()) {
+                attrs.push_back(*x);
+            }
+        }
+    }
+}
+
+DLIB::Group::index::~index()
+{
+    delete name_ids;
+    delete attr_ids;
+    for (size_t x=0; x<args.size(); ++x) {
+        delete args[x];
+    }
+}
+
+unsigned DLIB::Group::index::find(const char *name) const
+{
+    if (name_ids) {
+        return name_ids->find(name);
+    }
+    for (size_t x=0; x<names.size(); ++x) {
+        if (same_name(names[x],name)) {
+            return static_cast<unsigned>(x);
+        }
+    }
+    return NameIndex::npos;
+}
+
 // objlist is freed by the constructor
 DLIB::Group::Group(const char *name,const ArgList *args,list<Object*> *objs):
-    Object(name),_args(args)
+    Object(name),_args(args),_lazy(0),_table(0),_index(0)
 {
     if (objs) {
         for (list<Object*>::const_iterator x=objs->begin(); x!=objs->end(); ++x) {
@@ -171,6 +303,9 @@ DLIB::Group::Group(const char *name,const ArgList *args,list<Object*> *objs):
 
 DLIB::Group::~Group()
 {
+    delete _lazy;
+    delete _table.load();
+    delete _index.load();
     if (_args) {
         for (ArgList::const_iterator x=_args->begin(); x!=_args->end(); ++x) {
             delete *x;
@@ -185,12 +320,129 @@ DLIB::Group::~Group()
     }
 }
 
+// The cells of a lazy library are indexed once they are all parsed, until
+// then they are scanned. Threads racing on the first lookup may each build
+// an index, only one is kept.
+const DLIB::Group::index *DLIB::Group::get_index() const
+{
+    if (_lazy && !_lazy->done.load(memory_order_acquire)) {
+        return 0;
+    }
+    index *i = _index.load(memory_order_acquire);
+
+    if (!i) {
+        index *expected = 0;
+
+        i = new index(_groups,_attrs);
+        if (!_index.compare_exchange_strong(expected,i,memory_order_acq_rel)) {
+            delete i;
+            i = expected;
+        }
+    }
+    return i;
+}
+
 const DLIB::ArgList   *DLIB::Group::get_args()      const {return _args;}
-const DLIB::GroupList *DLIB::Group::get_subgroups() const {return &_groups;}
+const DLIB::GroupList *DLIB::Group::get_subgroups() const {parse_cells(); return &_groups;}
 const DLIB::AttrList  *DLIB::Group::get_attrs()     const {return &_attrs;}
-const DLIB::Attr      *DLIB::Group::find_attr(const char *name) const {return _attrs.find_attr(name);}
 const DLIB::Arg       *DLIB::Group::get_unique_arg()            const {return _args ? _args->get_unique_arg() : 0;}
-const vector<const DLIB::Group*> DLIB::Group::find_groups(const char *name) const {return _groups.find_groups(name);}
+
+const char *DLIB::Group::get_unique_name() const
+{
+    const Arg *a = get_unique_arg();
+
+    return a ? a->get_string() : 0;
+}
+
+const DLIB::Attr *DLIB::Group::find_attr(const char *name) const
+{
+    const index *i = (_attrs.size() > index::many) ? get_index() : 0;
+
+    if (!i) {
+        return _attrs.find_attr(name);
+    }
+    const unsigned x = i->attr_ids->find(name);
+
+    return (x == NameIndex::npos) ? 0 : i->attrs[x];
+}
+
+DLIB::GroupRange DLIB::Group::find_group_range(const char *name) const
+{
+    parse_cells();
+
+    const index   *i = _groups.empty() ? 0 : get_index();
+    const unsigned x = i ? i->find(name) : NameIndex::npos;
+
+    if (x == NameIndex::npos) {
+        return GroupRange(0,0);
+    }
+    return GroupRange(i->groups.data() + i->starts[x],i->groups.data() + i->starts[x+1]);
+}
+
+// Until the cells of a lazy library are all parsed, parse_cells() may be
+// inserting them in _groups: the scans hold the lock of the library.
+const vector<const DLIB::Group*> DLIB::Group::find_groups(const char *name) const
+{
+    if (_lazy && !_lazy->done.load(memory_order_acquire) && !same_name(_lazy->cell_name,name)) {
+        lock_guard<mutex> g(_lazy->lock);
+
+        return _groups.find_groups(name);
+    }
+    const GroupRange r = find_group_range(name);
+
+    return vector<const Group*>(r.begin(),r.end());
+}
+
+static const DLIB::Group *scan_group(const DLIB::GroupList &groups,const char *name,const char *arg)
+{
+    for (DLIB::GroupList::const_iterator x=groups.begin(); x!=groups.end(); ++x) {
+        const char *a = same_name((*x)->get_name(),name) ? (*x)->get_unique_name() : 0;
+
+        if (a && !strcmp(a,arg)) {
+            return *x;
+        }
+    }
+    return 0;
+}
+
+const DLIB::Group *DLIB::Group::find_group(const char *name,const char *arg) const
+{
+    if (_lazy && same_name(_lazy->cell_name,name)) {
+        const Group *g = _lazy->find(arg);
+
+        if (g) {
+            return g;
+        }
+    }
+    if (_lazy && !_lazy->done.load(memory_order_acquire)) {
+        lock_guard<mutex> g(_lazy->lock);
+
+        return scan_group(_groups,name,arg);
+    }
+    const index *i = _groups.empty() ? 0 : get_index();
+
+    if (!i) {
+        return scan_group(_groups,name,arg);
+    }
+    const unsigned x = i->find(name);
+
+    if (x == NameIndex::npos) {
+        return 0;
+    }
+    if (i->args[x]) {
+        const unsigned p = i->args[x]->find(arg);
+
+        return (p == NameIndex::npos) ? 0 : i->groups[i->starts[x] + p];
+    }
+    for (unsigned p=i->starts[x]; p<i->starts[x+1]; ++p) {
+        const char *a = i->groups[p]->get_unique_name();
+
+        if (a && !strcmp(a,arg)) {
+            return i->groups[p];
+        }
+    }
+    return 0;
+}
 
 
 //-----------------------------------------------------------------------------
@@ -273,6 +525,15 @@ const char  *DLIB::Arg::get_text()    const
     }
 }
 
+const char  *DLIB::Arg::get_string()  const
+{
+    if (get_type() == T_KEYWORD || get_type() == T_TEXT) {
+        return _str;
+    } else {
+        return 0;
+    }
+}
+
 const vector<float> DLIB::Arg::get_text_as_vector() const
 {
     vector<float> v;
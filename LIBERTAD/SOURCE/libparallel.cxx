@@ -0,0 +1,76 @@
+// .LIB reader
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <atomic>
+#include <vector>
+#include "libobjects.hxx"
+#include "libparser.hxx"
+#include "MappedFile.hxx"
+#include "ThreadPool.hxx"
+
+using namespace std;
+
+// The groups of the library body (see scan_top_groups()) are parsed in
+// chunks of about the same size, one task per chunk, and the library itself
+// is parsed without them by one more task. The groups are then appended to
+// the library in file order, after its other contents, which is where the
+// sequential parser puts them.
+
+pair<bool,DLIB::Group*> DLIB::parse_lib_file_parallel(const char *filename,const unsigned nthreads)
+{
+    MappedFile       file;
+    vector<TopGroup> tops;
+
+    if (!filename || !file.open(filename) || !scan_top_groups(file.data(),file.size(),&tops) || tops.size() < 2) {
+        return parse_lib_file(filename);
+    }
+    ThreadPool     pool(nthreads);
+    const size_t   total  = tops.back().end - tops.front().begin;
+    const size_t   target = total / (pool.size() * 8) + 1;
+    vector<size_t> chunks;  // First group of each chunk
+
+    for (size_t x=0,bytes=target; x<tops.size(); ++x) {
+        if (bytes >= target) {
+            chunks.push_back(x);
+            bytes = 0;
+        }
+        bytes += tops[x].end - tops[x].begin;
+    }
+    chunks.push_back(tops.size());
+
+    vector<Group*> groups(tops.size(),static_cast<Group*>(0));
+    ParseContext   ctx;
+    atomic<bool>   isok(true);
+
+    pool.run(chunks.size(),[&](size_t t) {
+        if (t == chunks.size() - 1) {
+            vector<char> skeleton = strip_top_groups(file.data(),file.size(),tops,false);
+
+            if (!parse_lib_buffer(&ctx,skeleton.data(),skeleton.size() - 2)) {
+                isok.store(false,memory_order_relaxed);
+            }
+            return;
+        }
+        for (size_t x=chunks[t]; x<chunks[t+1]; ++x) {
+            bool ok;
+
+            groups[x] = parse_top_group(file.data(),tops[x],&ok);
+            if (!ok) {
+                isok.store(false,memory_order_relaxed);
+            }
+        }
+    });
+
+    if (!isok.load() || !ctx.top) {
+        for (size_t x=0; x<groups.size(); ++x) {
+            delete groups[x];
+        }
+        delete ctx.top;
+        return make_pair(false,static_cast<Group*>(0));
+    }
+    for (size_t x=0; x<groups.size(); ++x) {
+        ctx.top->_groups.push_back(groups[x]);
+    }
+    return make_pair(true,ctx.top);
+}
@@ -0,0 +1,81 @@
+// .LIB reader
+// Author: David Berthelot
+//
+// Per parse state shared by the reentrant lexer and parser, and the scan of
+// the groups of a library body (internal header)
+
+#ifndef DLIB_PARSER_H
+#define DLIB_PARSER_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <vector>
+#include "libobjects.hxx"
+
+class LexemeTable;
+extern LexemeTable *DLIB_LEXEMES;
+
+namespace DLIB {
+    struct EventParse;
+
+    /// @internal State of one parse, lets several libraries, or parts of one, be parsed at the same time
+    struct ParseContext {
+        Group       *top;      ///< The group parsed, 0 until the parse succeeds
+        int          line;
+        const char  *text,*end; ///< Rest of the buffer read by the hand written tokenizer, 0 with the flex scanner
+        LexemeTable *lexemes;  ///< Interns the lexemes of the parse
+        EventParse  *events;   ///< Turns the groups and attributes into events instead of building them, else 0
+        unsigned     skip;     ///< Braces left to close in the body the flex scanner skips for the events, 0 when scanning
+
+        ParseContext(const int l=1):top(0),line(l),text(0),end(0),lexemes(DLIB_LEXEMES),events(0),skip(0) {}
+    };
+
+    /// @internal Raises the events of parse_lib_file_events() from the actions of the grammar (libevents.cxx)
+    struct EventParse {
+        EventHandler          *handler;
+        vector<vector<const char*> > filters;  // Names of each filter, 0 for "*", STAR_STAR for "**"
+        GroupPath              path;
+        vector<char>           states;         // Of the groups of path
+        LexemeTable           *previous;       // Lexemes before the last swap: the lookahead token may point into them
+
+        EventParse(EventHandler *h,const vector<const char*> &f);
+        ~EventParse();
+
+        void   begin_group(ParseContext *ctx,const char *name,const ArgList *args); ///< Skips the body of the group when it is filtered out
+        Group *end_group(ParseContext *ctx,const ArgList *args,list<Object*> *items); ///< Returns 0, takes args and items
+        Attr  *attribute(ParseContext *ctx,Attr *a);                                ///< Returns 0, takes a
+    };
+
+    /// @internal Parses text with the hand written tokenizer whatever use_hand_written_tokenizer() selected
+    bool parse_lib_text(ParseContext *ctx,const char *text,const size_t len);
+    /// @internal Returns the closing brace of the group whose body starts at text, end if there is none (libtoken.cxx)
+    /** Strings and comments are skipped, line is advanced as the tokenizer would */
+    const char *skip_group_body(const char *text,const char *end,int *line);
+
+    /// @internal Parses f into ctx->top, returns false on syntax errors
+    bool parse_lib_stream(ParseContext *ctx,FILE *f);
+    /// @internal Same as parse_lib_stream, scanning buf in place. buf[len] and buf[len+1] must be 0, the scanner writes to buf
+    bool parse_lib_buffer(ParseContext *ctx,char *buf,const size_t len);
+    /// @internal True when use_hand_written_tokenizer() selected the tokenizer of libtoken.cxx for parse_lib_buffer()
+    bool hand_written_tokenizer();
+    /// @internal Runs the flex scanner and the hand written tokenizer over text and compares their tokens
+    /** @return false at the first difference, which is reported. ntokens is the number of tokens compared */
+    bool diff_lib_tokens(const char *text,const size_t len,size_t *ntokens);
+
+    /// @internal A group found directly in the body of the library by scan_top_groups()
+    struct TopGroup {
+        size_t       begin,end;     ///< Bytes of the group, from its name to its closing brace
+        int          line,end_line; ///< Of begin and end
+        const char  *cell;          ///< Lexeme of the name of a cell group, 0 for other groups
+    };
+
+    /// @internal Locates the groups of the library body without parsing, strings and comments are skipped
+    /** @return false when the text doesn't look like a library, it should then be parsed as a whole */
+    bool         scan_top_groups(const char *text,const size_t len,vector<TopGroup> *groups);
+    /// @internal Copies text without the groups (or only without the cells), keeping their line breaks. The copy is padded for parse_lib_buffer()
+    vector<char> strip_top_groups(const char *text,const size_t len,const vector<TopGroup> &groups,const bool cells_only);
+    /// @internal Parses one group of the library body on its own
+    Group       *parse_top_group(const char *text,const TopGroup &g,bool *isok);
+};
+
+#endif
@@ -0,0 +1,191 @@
+// .LIB reader
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "libobjects.hxx"
+#include "libparser.hxx"
+#include "LexemeTable.hxx"
+#include "TextHash.hxx"
+
+using namespace std;
+
+extern LexemeTable *DLIB_LEXEMES;
+
+// The groups of a library body can be parsed on their own: they are found
+// by a scan that only matches braces, much faster than the parser. The
+// library itself is then parsed from a copy of the file without them. The
+// line breaks of the groups are kept in the copy, and each group is parsed
+// from its first line, so that messages report the lines of the file.
+
+static inline bool is_word_char(const char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+            c == '_' || c == '.' || c == '!' || c == '-' || c == '[' || c == ']';
+}
+
+static inline bool is_space(const char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\\';
+}
+
+static bool is_cell_keyword(const char *text,const size_t len)
+{
+    static const char cell[] = "cell";
+
+    if (len != sizeof(cell) - 1) {
+        return false;
+    }
+    for (size_t x=0; x<len; ++x) {
+        if (lower_ascii(text[x]) != cell[x]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The name of a cell is its single argument, quoted or not, 0 if the scan
+// can't make sense of it
+static const char *get_cell_name(const char *text,size_t len)
+{
+    while (len && is_space(*text)) {
+        ++text;
+        --len;
+    }
+    while (len && is_space(text[len-1])) {
+        --len;
+    }
+    if (len >= 2 && text[0] == '"' && text[len-1] == '"') {
+        ++text;
+        len -= 2;
+    }
+    if (!len) {
+        return 0;
+    }
+    for (size_t x=0; x<len; ++x) {
+        if (text[x] == ',' || text[x] == '"' || text[x] == '(' || text[x] == ')' || is_space(text[x])) {
+            return 0;
+        }
+    }
+    return DLIB_LEXEMES->get(text,len);
+}
+
+// The header of a group in the library body is the last word seen before
+// a parenthesis, the parenthesis and the opening brace
+bool DLIB::scan_top_groups(const char *text,const size_t len,vector<TopGroup> *groups)
+{
+    const size_t npos      = ~size_t(0);
+    size_t       depth     = 0;
+    size_t       parens    = 0;
+    int          line      = 1;
+    size_t       word      = npos,word_end = 0;
+    int          word_line = 0;
+    size_t       args      = npos,args_end = npos;
+    TopGroup     g;
+
+    for (size_t x=0; x<len; ++x) {
+        const char ch = text[x];
+
+        if (ch == '\n') {
+            ++line;
+        } else if (ch == '"') {
+            // As in the scanner, the line breaks of strings are not counted
+            for (++x; x < len && text[x] != '"'; ++x) {
+                if (text[x] == '\\' && x+1 < len && text[x+1] == '"') {
+                    ++x;
+                }
+            }
+            if (x >= len) {
+                return false;
+            }
+            if (!parens) {
+                word = npos;
+            }
+        } else if (ch == '/' && x+1 < len && text[x+1] == '*') {
+            for (x+=2; x+1 < len && (text[x] != '*' || text[x+1] != '/'); ++x) {
+                line += text[x] == '\n';
+            }
+            if (x+1 >= len) {
+                return false;
+            }
+            ++x;
+        } else if (is_space(ch)) {
+        } else if (depth == 1 && !parens && is_word_char(ch)) {
+            word      = x;
+            word_line = line;
+            while (x+1 < len && is_word_char(text[x+1])) {
+                ++x;
+            }
+            word_end = x+1;
+            args     = npos;
+            args_end = npos;
+        } else if (ch == '(') {
+            if (depth == 1 && parens++ == 0) {
+                args = x+1;
+            }
+        } else if (ch == ')') {
+            if (depth == 1 && parens && --parens == 0) {
+                args_end = x;
+            }
+        } else if (ch == '{') {
+            if (depth == 1) {
+                if (word == npos || args == npos || args_end == npos) {
+                    return false;
+                }
+                g.begin = word;
+                g.line  = word_line;
+                g.cell  = is_cell_keyword(text + word,word_end - word) ? get_cell_name(text + args,args_end - args) : 0;
+                parens  = 0;
+            }
+            ++depth;
+            word = npos;
+        } else if (ch == '}') {
+            if (!depth) {
+                return false;
+            }
+            if (--depth == 1) {
+                g.end      = x+1;
+                g.end_line = line;
+                groups->push_back(g);
+            }
+            if (!depth) {
+                return true;
+            }
+            word = npos;
+        } else if (!parens) {
+            word = npos;
+        }
+    }
+    return false;
+}
+
+vector<char> DLIB::strip_top_groups(const char *text,const size_t len,const vector<TopGroup> &groups,const bool cells_only)
+{
+    vector<char> v;
+    size_t       from = 0;
+
+    for (size_t x=0; x<groups.size(); ++x) {
+        const TopGroup &g = groups[x];
+
+        if (cells_only && !g.cell) {
+            continue;
+        }
+        v.insert(v.end(),text + from,text + g.begin);
+        v.insert(v.end(),g.end_line - g.line,'\n');
+        from = g.end;
+    }
+    v.insert(v.end(),text + from,text + len);
+    v.resize(v.size() + 2,0);
+    return v;
+}
+
+DLIB::Group *DLIB::parse_top_group(const char *text,const TopGroup &g,bool *isok)
+{
+    vector<char> buf(text + g.begin,text + g.end);
+    ParseContext ctx(g.line);
+
+    buf.resize(buf.size() + 2,0);
+    *isok = parse_lib_buffer(&ctx,buf.data(),g.end - g.begin);
+    return ctx.top;
+}
@@ -0,0 +1,378 @@
+// .LIB reader
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <charconv>
+#include <list>
+#include <string>
+#include "LexemeTable.hxx"
+#include "libobjects.hxx"
+#include "libparser.hxx"
+#include "libfile.tab.hxx"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+extern LexemeTable *DLIB_LEXEMES;
+
+// A hand written replacement of the flex scanner of libfile.l, it returns
+// the same tokens, values and line numbers. Where several rules of the
+// scanner match, flex takes the longest match, then the first rule:
+// - after a digit, 1'b0 is a W_NUMBER, then the longest of NUMBER and
+//   USTR wins (1.5e-3 is a number, 1e5 or 1.2.3 are strings)
+// - after a letter, ID always matches at least what USTR does
+// - a string ends at the first quote not preceded by a backslash, or if
+//   there is none at the last quote of the text. Newlines in strings are
+//   not counted, as in the scanner
+// Runs of blanks, comments and strings are scanned 16 bytes at a time
+// with SSE2. Numbers are read with from_chars as a double, rounded to a
+// float like the atof of the scanner.
+
+static atomic<bool> HAND_WRITTEN(false);
+
+void DLIB::use_hand_written_tokenizer(const bool enable) {HAND_WRITTEN = enable;}
+bool DLIB::hand_written_tokenizer()                      {return HAND_WRITTEN;}
+
+enum {C_ALPHA=1,C_DIGIT=2,C_ID=4,C_BLANK=8};
+
+struct CharClasses {
+    unsigned char c[256];
+
+    CharClasses() {
+        for (int x=0; x<256; ++x) {
+            const bool alpha = (x >= 'a' && x <= 'z') || (x >= 'A' && x <= 'Z');
+            const bool digit = x >= '0' && x <= '9';
+
+            c[x] = (alpha ? C_ALPHA : 0) | (digit ? C_DIGIT : 0) |
+                   ((alpha || digit || x == '!' || x == '-' || x == '_' || x == '.') ? C_ID : 0) |
+                   ((x == ' ' || x == '\t' || x == '\r' || x == '\\' || x == '\n') ? C_BLANK : 0);
+        }
+    }
+};
+
+static const CharClasses CLASSES;
+
+static inline bool is(const char c,const unsigned char cls) {return CLASSES.c[static_cast<unsigned char>(c)] & cls;}
+
+#ifdef __SSE2__
+static inline unsigned mask_of(const __m128i v,const char c)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v,_mm_set1_epi8(c)));
+}
+#endif
+
+// Skips blanks and line breaks
+static const char *skip_blanks(const char *p,const char *e,int *line)
+{
+#ifdef __SSE2__
+    while (p + 16 <= e) {
+        const __m128i  v     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned nl    = mask_of(v,'\n');
+        const unsigned other = ~(nl | mask_of(v,' ') | mask_of(v,'\t') | mask_of(v,'\r') | mask_of(v,'\\')) & 0xffff;
+
+        if (other) {
+            const unsigned n = __builtin_ctz(other);
+
+            *line += __builtin_popcount(nl & ((1u << n) - 1));
+            return p + n;
+        }
+        *line += __builtin_popcount(nl);
+        p     += 16;
+    }
+#endif
+    for (; p < e && is(*p,C_BLANK); ++p) {
+        *line += *p == '\n';
+    }
+    return p;
+}
+
+// Returns the end of the comment starting at p, after the "/*"
+static const char *skip_comment(const char *p,const char *e,int *line)
+{
+#ifdef __SSE2__
+    while (p + 16 <= e) {
+        const __m128i v    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned nl  = mask_of(v,'\n');
+        unsigned       end = mask_of(v,'*');
+
+        for (; end; end &= end - 1) {
+            const unsigned n = __builtin_ctz(end);
+
+            if (p + n + 1 < e && p[n+1] == '/') {
+                *line += __builtin_popcount(nl & ((1u << n) - 1));
+                return p + n + 2;
+            }
+        }
+        *line += __builtin_popcount(nl);
+        p     += 16;
+    }
+#endif
+    for (; p < e; ++p) {
+        if (*p == '*' && p + 1 < e && p[1] == '/') {
+            return p + 2;
+        }
+        *line += *p == '\n';
+    }
+    return e;
+}
+
+// Returns the closing quote of the string whose text starts at p, 0 if there is none
+static const char *find_quote(const char *p,const char *e)
+{
+    const char *last = 0;
+
+#ifdef __SSE2__
+    while (p + 16 <= e) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+        for (unsigned q=mask_of(v,'"'); q; q &= q - 1) {
+            const char *quote = p + __builtin_ctz(q);
+
+            if (quote[-1] != '\\') {
+                return quote;
+            }
+            last = quote;
+        }
+        p += 16;
+    }
+#endif
+    for (; p < e; ++p) {
+        if (*p == '"') {
+            if (p[-1] != '\\') {
+                return p;
+            }
+            last = p;
+        }
+    }
+    return last;
+}
+
+// Only braces, strings, comments and line breaks matter to a skipped body
+const char *DLIB::skip_group_body(const char *p,const char *e,int *line)
+{
+    size_t depth = 0;
+
+    for (;;) {
+#ifdef __SSE2__
+        while (p + 16 <= e) {
+            const __m128i  v    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const unsigned nl   = mask_of(v,'\n');
+            const unsigned stop = mask_of(v,'{') | mask_of(v,'}') | mask_of(v,'"') | mask_of(v,'/');
+
+            if (stop) {
+                const unsigned n = __builtin_ctz(stop);
+
+                *line += __builtin_popcount(nl & ((1u << n) - 1));
+                p     += n;
+                break;
+            }
+            *line += __builtin_popcount(nl);
+            p     += 16;
+        }
+#endif
+        for (; p < e && *p != '{' && *p != '}' && *p != '"' && *p != '/'; ++p) {
+            *line += *p == '\n';
+        }
+        if (p >= e) {
+            return e;
+        }
+        switch (*p) {
+        case '{':
+            ++depth;
+            ++p;
+            break;
+        case '}':
+            if (!depth) {
+                return p;
+            }
+            --depth;
+            ++p;
+            break;
+        case '"': {
+            const char *q = find_quote(p + 1,e);
+
+            p = q ? q + 1 : p + 1;
+            break;
+        }
+        default:
+            p = (p + 1 < e && p[1] == '*') ? skip_comment(p + 2,e,line) : p + 1;
+            break;
+        }
+    }
+}
+
+// Length of the NUMBER or FNUMBER at p, 0 if there is none
+static size_t number_length(const char *p,const char *e)
+{
+    const char *s = p;
+
+    if (p < e && *p == '-') {
+        ++p;
+    }
+    if (p < e && is(*p,C_DIGIT)) {
+        while (p < e && (is(*p,C_DIGIT) || *p == '_')) {
+            ++p;
+        }
+        if (p + 1 < e && *p == '.' && is(p[1],C_DIGIT)) {
+            for (++p; p < e && (is(*p,C_DIGIT) || *p == '_'); ++p);
+        }
+    } else if (p + 1 < e && *p == '.' && is(p[1],C_DIGIT)) {
+        for (++p; p < e && (is(*p,C_DIGIT) || *p == '_'); ++p);
+    } else {
+        return 0;
+    }
+    if (p + 2 < e && (*p == 'e' || *p == 'E') && (p[1] == '+' || p[1] == '-') && is(p[2],C_DIGIT)) {
+        for (p+=2; p < e && is(*p,C_DIGIT); ++p);
+    }
+    return p - s;
+}
+
+// Length of the ID at p, which starts with a letter. Brackets are part of
+// an ID when they are followed by digits and brackets, then a letter
+static size_t id_length(const char *p,const char *e)
+{
+    const char *s = p++;
+
+    for (;;) {
+        while (p < e && is(*p,C_ID)) {
+            ++p;
+        }
+        if (p < e && (*p == '[' || *p == ']')) {
+            const char *q = p + 1;
+
+            while (q < e && (is(*q,C_DIGIT) || *q == '[' || *q == ']')) {
+                ++q;
+            }
+            if (q < e && is(*q,C_ID) && !is(*q,C_DIGIT)) {
+                p = q + 1;
+                continue;
+            }
+        }
+        return p - s;
+    }
+}
+
+// Length of the USTR at p, which starts with a letter or a digit
+static size_t ustr_length(const char *p,const char *e)
+{
+    const char *s = p++;
+
+    while (p < e && is(*p,C_ID)) {
+        ++p;
+    }
+    return p - s;
+}
+
+// Numbers out of the range of a double are left to atof, which returns
+// infinity or 0 where from_chars fails
+static int number(YYSTYPE *lval,const char *p,const size_t len)
+{
+    double d = 0;
+
+    if (from_chars(p,p + len,d).ec != errc()) {
+        d = atof(string(p,len).c_str());
+    }
+    lval->f_number = d;
+    return F_NUMBER;
+}
+
+int DLIB::next_lib_token(YYSTYPE *lval,ParseContext *ctx)
+{
+    const char *e = ctx->end;
+
+    for (;;) {
+        const char *p = skip_blanks(ctx->text,e,&ctx->line);
+
+        if (p >= e) {
+            ctx->text = e;
+            return 0;
+        }
+        const char c = *p;
+
+        ctx->text = p + 1;
+        if (is(c,C_DIGIT)) {
+            if (c == '1' && p + 3 < e && p[1] == '\'' && p[2] == 'b' && (p[3] == '0' || p[3] == '1')) {
+                ctx->text      = p + 4;
+                lval->c_lexeme = ctx->lexemes->get(p,size_t(4));
+                return W_NUMBER;
+            }
+            const size_t n = number_length(p,e);
+            const size_t u = ustr_length(p,e);
+
+            ctx->text = p + (n >= u ? n : u);
+            if (n >= u) {
+                return number(lval,p,n);
+            }
+            lval->c_lexeme = ctx->lexemes->get(p,u);
+            return W_STRING_LITERAL;
+        }
+        if (is(c,C_ALPHA)) {
+            const size_t n = id_length(p,e);
+
+            ctx->text      = p + n;
+            lval->c_lexeme = ctx->lexemes->get(p,n);
+            return W_ID;
+        }
+        switch (c) {
+        case '-':
+        case '.': {
+            const size_t n = number_length(p,e);
+
+            if (n) {
+                ctx->text = p + n;
+                return number(lval,p,n);
+            }
+            if (c == '-') {
+                return K_MINUS;
+            }
+            break;
+        }
+        case '"': {
+            const char *q = find_quote(p + 1,e);
+
+            if (q) {
+                ctx->text      = q + 1;
+                lval->c_lexeme = ctx->lexemes->get(p + 1,size_t(q - p - 1));
+                return W_STRING_LITERAL;
+            }
+            break;
+        }
+        case '/':
+            if (p + 1 < e && p[1] == '*') {
+                ctx->text = skip_comment(p + 2,e,&ctx->line);
+                continue;
+            }
+            return K_DIV;
+        case '=':
+            if (p + 1 < e && p[1] == '=') {
+                ctx->text = p + 2;
+                return K_EQUAL;
+            }
+            break;
+        case '[':  return K_OPEN_SQUARE;
+        case ']':  return K_CLOSE_SQUARE;
+        case '(':  return K_OPEN_PAREN;
+        case ')':  return K_CLOSE_PAREN;
+        case '{':  return K_OPEN_BRACE;
+        case '}':  return K_CLOSE_BRACE;
+        case ':':  return K_COLON;
+        case ';':  return K_SEMICOLON;
+        case ',':  return K_COMMA;
+        case '+':  return K_PLUS;
+        case '*':  return K_MULT;
+        case '|':  return K_OR;
+        case '^':  return K_XOR;
+        case '&':  return K_AND;
+        case '!':  return K_NOT;
+        case '\'': return K_POST_NOT;
+        }
+        const char text[2] = {c,0};
+
+        printf("LIB-002:%d: illegal token '%s'\n",ctx->line,text);
+    }
+}
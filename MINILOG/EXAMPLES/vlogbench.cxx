@@ -0,0 +1,246 @@
+// Verilog netlist reader benchmark
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <string>
+#include "vlogobjects.hxx"
+
+using namespace std;
+
+// Usage: vlogbench.exe [-n runs] [-m] [-s] [-e] [-r] file
+//   Compares the parse throughput of stdio input, scanned as it is read,
+//   and memory mapped input.
+//   -m reports the memory used per instance and the design teardown time.
+//   -s compares with saving and loading a snapshot (written next to file).
+//   -e compares with streaming the file to a handler that counts objects.
+//   -r times the reload of a copy of the file (written next to file) when it
+//   is unchanged and after an edit.
+
+static double seconds_since(const chrono::steady_clock::time_point &start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Best of runs, in seconds
+static double time_parse(const char *filename,const bool use_mmap,const int runs,bool *isok)
+{
+    double best = 0;
+
+    for (int x=0; x<runs; ++x) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        pair<bool,VLP::Design*>                g     = VLP::parse_vlog_file(filename,false,use_mmap);
+        const double                           t     = seconds_since(start);
+
+        *isok = *isok && g.first;
+        delete g.second;
+        best = (x == 0 || t < best) ? t : best;
+    }
+    return best;
+}
+
+static size_t heap_in_use()
+{
+    const struct mallinfo2 m = mallinfo2();
+
+    return m.uordblks + m.hblkhd;
+}
+
+static bool report_memory(const char *filename)
+{
+    const size_t                           before = heap_in_use();
+    pair<bool,VLP::Design*>                g      = VLP::parse_vlog_file(filename,false);
+    const size_t                           used   = heap_in_use() - before;
+    size_t                                 ninst  = 0;
+
+    for (VLP::ModuleList::const_iterator x=g.second->get_modules().begin(); x!=g.second->get_modules().end(); ++x) {
+        ninst += (*x)->get_instance_list().size();
+    }
+    const chrono::steady_clock::time_point start  = chrono::steady_clock::now();
+    delete g.second;
+    const double                           t      = seconds_since(start);
+
+    printf("    memory %8.1f MB %8zu instances %8.1f bytes/instance\n",used / 1e6,ninst,ninst ? double(used) / ninst : 0.0);
+    printf("    teardown %6.3f s\n",t);
+    return g.first;
+}
+
+// Counts the objects, samples the heap every few thousand objects
+class counter : public VLP::StreamHandler {
+public:
+    size_t modules,wires,assigns,insts,base,peak;
+
+    counter():modules(0),wires(0),assigns(0),insts(0),base(heap_in_use()),peak(0) {}
+
+    void on_module_begin(const char *,const VLP::NameList &) {++modules;}
+    void on_wire(const VLP::Wire *)                          {sample(++wires);}
+    void on_assign(const VLP::Assign *)                      {sample(++assigns);}
+    void on_instance(const VLP::Inst *)                      {sample(++insts);}
+
+private:
+    void sample(const size_t n) {
+        if ((n & 4095) == 0) {
+            const size_t h = heap_in_use();
+
+            peak = (h > base && h - base > peak) ? h - base : peak;
+        }
+    }
+};
+
+static bool report_stream(const char *filename,const int runs,const double tparse,const double mb)
+{
+    double best = 0;
+    bool   isok = true;
+
+    for (int x=0; x<runs; ++x) {
+        counter                                c;
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        isok = VLP::stream_vlog_file(filename,&c) && isok;
+        const double t = seconds_since(start);
+
+        best = (x == 0 || t < best) ? t : best;
+        if (x == runs - 1) {
+            printf("    stream %7.3f s %8.1f MB/s (%.1fx the parse), %zu modules %zu wires %zu assigns %zu instances, peak heap %.1f MB\n",
+                   best,mb / best,tparse / best,c.modules,c.wires,c.assigns,c.insts,c.peak / 1e6);
+        }
+    }
+    return isok;
+}
+
+// Best of runs for the load, in seconds
+static bool report_snapshot(const char *filename,const int runs,const double tparse)
+{
+    const string                           snap  = string(filename) + ".snap";
+    pair<bool,VLP::Design*>                g     = VLP::parse_vlog_file(filename,false);
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool                                   isok  = g.second->save_snapshot(snap.c_str());
+    const double                           tsave = seconds_since(start);
+    double                                 best  = 0;
+    struct stat                            st;
+
+    delete g.second;
+    for (int x=0; isok && x<runs; ++x) {
+        const chrono::steady_clock::time_point s = chrono::steady_clock::now();
+        VLP::Design                           *d = VLP::Design::load_snapshot(snap.c_str());
+        const double                           t = seconds_since(s);
+
+        isok = d != 0;
+        delete d;
+        best = (x == 0 || t < best) ? t : best;
+    }
+    if (isok && !stat(snap.c_str(),&st)) {
+        printf("    snapshot %6.1f MB save %6.3f s load %6.3f s (%.1fx faster than parsing)\n",st.st_size / 1e6,tsave,best,tparse / best);
+    }
+    remove(snap.c_str());
+    return isok && g.first;
+}
+
+// Best of runs for the unchanged reload, the edited reload is timed once
+static bool report_reload(const char *filename,const int runs,const double tparse)
+{
+    const string             copy = string(filename) + ".reload.v";
+    FILE                    *in   = fopen(filename,"r");
+    FILE                    *out  = fopen(copy.c_str(),"w");
+    char                     buf[64 * 1024];
+    pair<bool,VLP::Design*>  g(false,0);
+    double                   best = 0;
+    bool                     isok = in && out;
+
+    for (size_t n; isok && (n = fread(buf,1,sizeof(buf),in)) > 0; ) {
+        isok = fwrite(buf,1,n,out) == n;
+    }
+    if (in) {
+        fclose(in);
+    }
+    if (out) {
+        fclose(out);
+    }
+    if (isok) {
+        g    = VLP::parse_vlog_file(copy.c_str(),false);
+        isok = g.first;
+    }
+    for (int x=0; isok && x<runs; ++x) {
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        isok = g.second->reload(copy.c_str());
+
+        const double t = seconds_since(start);
+
+        best = (x == 0 || t < best) ? t : best;
+    }
+    out  = isok ? fopen(copy.c_str(),"a") : 0;
+    isok = out && fputs("\n// edited\n",out) >= 0;
+    if (out) {
+        fclose(out);
+    }
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    isok = isok && g.second->reload(copy.c_str());
+
+    const double tedit = seconds_since(start);
+
+    if (isok) {
+        printf("    reload unchanged %8.4f s (%.0fx faster than parsing), edited %6.3f s\n",best,tparse / best,tedit);
+    }
+    delete g.second;
+    remove(copy.c_str());
+    return isok;
+}
+
+int main(int argc,char **argv)
+{
+    int         runs     = 3;
+    bool        memory   = false;
+    bool        snapshot = false;
+    bool        stream   = false;
+    bool        reload   = false;
+    const char *filename = 0;
+
+    for (int x=1; x<argc; ++x) {
+        if (!strcmp(argv[x],"-n") && x+1 < argc) {
+            runs = atoi(argv[++x]);
+        } else if (!strcmp(argv[x],"-m")) {
+            memory = true;
+        } else if (!strcmp(argv[x],"-s")) {
+            snapshot = true;
+        } else if (!strcmp(argv[x],"-e")) {
+            stream = true;
+        } else if (!strcmp(argv[x],"-r")) {
+            reload = true;
+        } else {
+            filename = argv[x];
+        }
+    }
+    struct stat st;
+    if (!filename || stat(filename,&st)) {
+        printf("Usage: %s [-n runs] [-m] [-s] [-e] [-r] file\n",argv[0]);
+        return 1;
+    }
+    const double mb   = st.st_size / 1e6;
+    bool         isok = true;
+
+    printf("%s: %.1f MB, best of %d runs\n",filename,mb,runs);
+    const double tio  = time_parse(filename,false,runs,&isok);
+    printf("    stdio %8.3f s %8.1f MB/s\n",tio,mb / tio);
+    const double tmap = time_parse(filename,true,runs,&isok);
+    printf("    mmap  %8.3f s %8.1f MB/s\n",tmap,mb / tmap);
+    if (memory) {
+        isok = report_memory(filename) && isok;
+    }
+    if (snapshot) {
+        isok = report_snapshot(filename,runs,tmap < tio ? tmap : tio) && isok;
+    }
+    if (stream) {
+        isok = report_stream(filename,runs,tmap < tio ? tmap : tio,mb) && isok;
+    }
+    if (reload) {
+        isok = report_reload(filename,runs,tmap < tio ? tmap : tio) && isok;
+    }
+
+    return isok ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+// Verilog netlist reader query benchmark
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include "vlogobjects.hxx"
+#include "LexemeTable.hxx"
+
+using namespace std;
+
+// Usage: vlogquery.exe [-t threads] [-q queries] file
+//   N reader threads look up modules, wires and instances of a design by
+//   name at the same time, half of the lookups miss. Reports the lookup
+//   rate and checks that the design did not grow while being queried.
+
+struct query {
+    string module;
+    string name;     // Wire or instance, empty to look up the module only
+    bool   is_inst;
+    bool   hit;
+};
+
+static void reader(const VLP::Design *d,const vector<query> *queries,const size_t nqueries,const size_t start,atomic<size_t> *errors)
+{
+    size_t bad = 0;
+
+    for (size_t x=0; x<nqueries; ++x) {
+        const query        &q = (*queries)[(start + x) % queries->size()];
+        const VLP::Module  *m = d->get_module(q.module.data(),q.module.size());
+        bool                found;
+
+        if (q.name.empty() || !m) {
+            found = m != 0;
+        } else if (q.is_inst) {
+            found = m->find_instance(q.name.data(),q.name.size()) != 0;
+        } else {
+            found = m->find_wire(q.name.data(),q.name.size()) != 0;
+        }
+        bad += found != q.hit;
+    }
+    *errors += bad;
+}
+
+int main(int argc,char **argv)
+{
+    unsigned    nthreads = thread::hardware_concurrency();
+    size_t      nqueries = 1000000;
+    const char *filename = 0;
+
+    for (int x=1; x<argc; ++x) {
+        if (!strcmp(argv[x],"-t") && x+1 < argc) {
+            nthreads = atoi(argv[++x]);
+        } else if (!strcmp(argv[x],"-q") && x+1 < argc) {
+            nqueries = strtoul(argv[++x],0,10);
+        } else {
+            filename = argv[x];
+        }
+    }
+    if (!filename) {
+        printf("Usage: %s [-t threads] [-q queries] file\n",argv[0]);
+        return 1;
+    }
+    pair<bool,VLP::Design*> g = VLP::parse_vlog_file(filename,false);
+    const VLP::Design      *d = g.second;
+    vector<query>           queries;
+
+    // Names are copied so that lookups hash the text, as a script would
+    for (VLP::ModuleList::const_iterator m=d->get_modules().begin(); m!=d->get_modules().end(); ++m) {
+        const string mname = (*m)->get_name();
+        query        q     = {mname,"",false,true};
+
+        queries.push_back(q);
+        q.module = mname + "_nomodule";
+        q.hit    = false;
+        queries.push_back(q);
+        for (VLP::WireList::const_iterator w=(*m)->get_wire_list().begin(); w!=(*m)->get_wire_list().end(); ++w) {
+            query h = {mname,(*w)->get_name(),false,true};
+            query n = {mname,string((*w)->get_name()) + "_nowire",false,false};
+
+            queries.push_back(h);
+            queries.push_back(n);
+        }
+        for (VLP::InstList::const_iterator i=(*m)->get_instance_list().begin(); i!=(*m)->get_instance_list().end(); ++i) {
+            query h = {mname,(*i)->get_name(),true,true};
+            query n = {mname,string((*i)->get_name()) + "_noinst",true,false};
+
+            queries.push_back(h);
+            queries.push_back(n);
+        }
+    }
+    if (queries.empty()) {
+        printf("%s: empty design\n",filename);
+        return 1;
+    }
+
+    const size_t lexemes = d->get_lexemes()->size();
+    bool         isok    = g.first;
+
+    // The first lookups in a module build its name index
+    printf("%s: %zu distinct queries, %zu queries per thread\n",filename,queries.size(),nqueries);
+    {
+        atomic<size_t>                         errors(0);
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        reader(d,&queries,queries.size(),0,&errors);
+        printf("    first pass %8.3f s (builds the indexes) %s\n",
+               chrono::duration<double>(chrono::steady_clock::now() - start).count(),errors ? "WRONG RESULTS" : "ok");
+        isok = isok && !errors;
+    }
+    for (unsigned n=1; n<=(nthreads ? nthreads : 1); n*=2) {
+        vector<thread>                         workers;
+        atomic<size_t>                         errors(0);
+        const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+        for (unsigned x=0; x<n; ++x) {
+            workers.push_back(thread(reader,d,&queries,nqueries,x * 104729 % queries.size(),&errors));
+        }
+        for (unsigned x=0; x<n; ++x) {
+            workers[x].join();
+        }
+        const double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        printf("    %2u threads %8.2f Mqueries/s %s\n",n,n * nqueries / secs / 1e6,errors ? "WRONG RESULTS" : "ok");
+        isok = isok && !errors;
+    }
+    printf("    lexemes %zu before, %zu after\n",lexemes,d->get_lexemes()->size());
+    isok = isok && lexemes == d->get_lexemes()->size();
+
+    delete g.second;
+    return isok ? 0 : 1;
+}
@@ -2,17 +2,48 @@
 // Author: David Berthelot
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "vlogobjects.hxx"
 
+// Usage: vlogreader.exe [-p] [-j nthreads] [-s snapshot] [-l snapshot] [file ...]
+//   -p prints the design, several files are parsed in parallel
+//   -s saves the design in a snapshot, -l loads a snapshot instead of parsing
 int main(int argc,char **argv)
 {
     pair<bool,VLP::Design*> g = make_pair(true,static_cast<VLP::Design*>(0));
-    const bool print = (argc > 1) ? strcmp(argv[1],"-p") == 0 : false;
+    bool                    print    = false;
+    unsigned                nthreads = 0;
+    vector<const char*>     files;
+    const char             *save     = 0;
+    const char             *load     = 0;
 
-    if ( argc > 1 ) {
-        printf("Reading verilog file %s\n",argv[argc-1]);
-        g = VLP::parse_vlog_file(argv[argc-1]);
+    for (int x=1; x<argc; ++x) {
+        if (!strcmp(argv[x],"-p")) {
+            print = true;
+        } else if (!strcmp(argv[x],"-j") && x+1 < argc) {
+            nthreads = atoi(argv[++x]);
+        } else if (!strcmp(argv[x],"-s") && x+1 < argc) {
+            save = argv[++x];
+        } else if (!strcmp(argv[x],"-l") && x+1 < argc) {
+            load = argv[++x];
+        } else {
+            files.push_back(argv[x]);
+        }
+    }
+
+    if (load) {
+        printf("Loading snapshot %s\n",load);
+        g = make_pair(true,VLP::Design::load_snapshot(load));
+        if (!g.second) {
+            return 1;
+        }
+    } else if (files.size() > 1) {
+        printf("Reading %d verilog files\n",int(files.size()));
+        g = VLP::parse_vlog_files(files,nthreads);
+    } else if (files.size() == 1) {
+        printf("Reading verilog file %s\n",files[0]);
+        g = VLP::parse_vlog_file(files[0]);
     } else {
         g = VLP::parse_vlog_file(0);
     }
@@ -24,6 +55,9 @@ int main(int argc,char **argv)
         //LEXEMES->print();
         printf("----------------------------------------\n");
     }
+    if (save && !g.second->save_snapshot(save)) {
+        g.first = false;
+    }
     if (print) {
         g.second->print();
     }
@@ -0,0 +1,117 @@
+/// @file   vlogbits.hxx
+/// @brief  Bit level connectivity index of a verilog module
+/// @author David Berthelot
+
+#ifndef VLOGNETLIST_BITS
+#define VLOGNETLIST_BITS
+
+#include <vector>
+#include "vlogobjects.hxx"
+
+using namespace std;
+
+class NameIndex;
+
+namespace VLP {
+    /// Bit level connectivity of one module: every wire bit has a number, every pin is an array of bit numbers
+    /** Each wire covers a block of consecutive bits, left to right as declared (wire [7:0] a: a[7] comes
+        first). Names used in expressions without a declaration are 1 bit implicit wires. The first bits are
+        the constants, so that a bit of a pin is either a wire bit or a constant.
+        The actual expression of every instance port, with its concatenations and part-selects, is expanded
+        once into the bits it connects, left to right. So are the ports of the module and both sides of the
+        assignments. Bits that do not exist (index out of range) are BIT_X. Assignments do not merge bits.
+        The index only depends on the module itself, it is kept valid when other modules of the design change.
+        Example: @code
+const VLP::BitIndex *bits = module->get_bit_index();
+const unsigned      *b    = bits->get_port_bits(inst,port);
+for (size_t x=0; x<bits->get_port_width(inst,port); ++x) {
+    if (!VLP::BitIndex::is_constant(b[x])) {
+        printf("%s[%d] has %zu pins\n",bits->get_wire_name(bits->get_wire_of(b[x])),bits->get_bit_index(b[x]),bits->get_bit_pin_count(b[x]));
+    }
+} @endcode
+    */
+    class BitIndex {
+    public:
+        static const unsigned npos = ~0u; ///< Returned by lookups that fail, also the instance of a module port pin
+
+        /// Constant bits, they are the first bits of every module
+        enum T_Const {BIT_0,     ///< Constant 0
+                      BIT_1,     ///< Constant 1
+                      BIT_X,     ///< Unknown value, also used for bits that do not exist (out of range index)
+                      BIT_Z,     ///< High impedance
+                      BIT_FIRST  ///< The first wire bit
+        };
+
+        /// A connection of a wire bit to one bit of an instance port (or of a port of the module itself)
+        struct Pin {
+            unsigned inst; ///< Index of the instance in Module::get_instance_list(), npos for a port of the module
+            unsigned port; ///< Index in Inst::get_ports(), or in Module::get_port_names() for a port of the module
+            unsigned bit;  ///< Index in the bits of that port (0 is the leftmost bit)
+        };
+
+        /// Builds the index of a module
+        /** @param m is the module, it must outlive the index */
+        BitIndex(const Module *m);
+        ~BitIndex();
+
+        const Module   *get_module()    const {return _module;}                            ///< Returns the indexed module
+        unsigned        get_bit_count() const {return _base.back();}                       ///< Returns the number of bits, including the constant bits
+        static bool     is_constant(const unsigned bit) {return bit < BIT_FIRST;}          ///< Returns true for BIT_0, BIT_1, BIT_X and BIT_Z
+
+        unsigned        get_wire_count() const {return static_cast<unsigned>(_names.size());} ///< Returns the number of wires, implicit ones included
+        unsigned        find_wire(const char *name) const;                                 ///< Returns the wire of that name, npos if there is none
+        const char     *get_wire_name(const unsigned w)  const {return _names[w];}         ///< Returns the name of a wire
+        const Wire     *get_wire_decl(const unsigned w)  const {return _wires[w];}         ///< Returns the declaration of a wire, 0 for implicit wires
+        unsigned        get_wire_base(const unsigned w)  const {return _base[w];}          ///< Returns the leftmost bit of a wire
+        unsigned        get_wire_width(const unsigned w) const {return _base[w+1] - _base[w];} ///< Returns the number of bits of a wire
+        unsigned        get_wire_of(const unsigned bit) const;                             ///< Returns the wire holding a bit that is not a constant
+        int             get_bit_index(const unsigned bit) const;                           ///< Returns the verilog index of a bit in its wire, -1 for scalar wires
+        unsigned        find_bit(const unsigned w,const int index) const;                  ///< Returns the bit of w[index] (index 0 for a scalar wire), BIT_X if out of range
+
+        /// Returns the bits connected to a port of an instance, left to right
+        const unsigned *get_port_bits(const unsigned inst,const unsigned port)  const {return _bits.data() + _port_bits[_inst_ports[inst] + port];}
+        size_t          get_port_width(const unsigned inst,const unsigned port) const {return _port_bits[_inst_ports[inst] + port + 1] - _port_bits[_inst_ports[inst] + port];}
+        /// Returns the position of a port of the module in Module::get_port_names(), npos if name is not a port
+        unsigned        find_port(const char *name) const;
+        /// Returns the bits of a port of the module, by position in Module::get_port_names(), BIT_X for an undeclared port
+        const unsigned *get_module_port_bits(const unsigned position)  const {return _bits.data() + _port_bits[_module_ports + position];}
+        size_t          get_module_port_width(const unsigned position) const {return _port_bits[_module_ports + position + 1] - _port_bits[_module_ports + position];}
+        /// Returns the bits of the left hand side of an assignment, by index in Module::get_assign_list()
+        const unsigned *get_lhs_bits(const unsigned assign)  const {return _bits.data() + _port_bits[_assigns + 2*assign];}
+        size_t          get_lhs_width(const unsigned assign) const {return _port_bits[_assigns + 2*assign + 1] - _port_bits[_assigns + 2*assign];}
+        /// Returns the bits of the right hand side of an assignment, constants included
+        const unsigned *get_rhs_bits(const unsigned assign)  const {return _bits.data() + _port_bits[_assigns + 2*assign + 1];}
+        size_t          get_rhs_width(const unsigned assign) const {return _port_bits[_assigns + 2*assign + 2] - _port_bits[_assigns + 2*assign + 1];}
+
+        /// Returns the pins of a wire bit: the ports of the module, then the instance ports in instance order
+        const Pin      *get_bit_pins(const unsigned bit)      const {return _pins.data() + _bit_pins[bit - BIT_FIRST];}
+        size_t          get_bit_pin_count(const unsigned bit) const {return _bit_pins[bit - BIT_FIRST + 1] - _bit_pins[bit - BIT_FIRST];}
+
+        /// Appends the bits of an expression of the module, left to right
+        void            append_bits(const Expr *e,vector<unsigned> &bits) const;
+
+    private:
+        const Module         *_module;
+        NameIndex            *_index;
+        NameIndex            *_port_index;  // Port name -> first position
+        vector<const char*>   _names;
+        vector<const Wire*>   _wires;
+        vector<unsigned>      _base;        // Wire -> first bit, size wires + 1
+        vector<Range>         _range;       // Declared range, (-1,-1) for scalars
+        vector<unsigned>      _inst_ports;  // CSR instance -> ports, size instances + 1
+        unsigned              _module_ports; // Module ports, then assignment sides, follow the instance ports
+        unsigned              _assigns;
+        vector<unsigned>      _port_bits;   // CSR port -> bits
+        vector<unsigned>      _bits;
+        vector<unsigned>      _bit_pins;    // CSR wire bit -> pins
+        vector<Pin>           _pins;
+
+        void                  add_wire(const char *name,const Wire *w,const Range *r);
+        void                  add_expr(const Expr *e);
+
+        BitIndex(const BitIndex&);
+        BitIndex &operator=(const BitIndex&);
+    };
+};
+
+#endif
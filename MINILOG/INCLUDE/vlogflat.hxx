@@ -0,0 +1,100 @@
+/// @file   vlogflat.hxx
+/// @brief  Flattened view of a verilog design
+/// @author David Berthelot
+
+#ifndef VLOGNETLIST_FLAT
+#define VLOGNETLIST_FLAT
+
+#include <string>
+#include <vector>
+#include "vlogobjects.hxx"
+
+using namespace std;
+
+namespace VLP {
+    /// A design flattened below a top module, built by Design::flatten()
+    /** Instances of user modules are expanded, what remains are the leaf instances (library cells and
+        primitives) and the nets connecting them. Nets are single bits: a bus of 8 bits is 8 nets, and the
+        ports of a leaf instance are bound to arrays of nets (one per bit of the actual expression, left to
+        right). Nets connected through ports of user modules or through assignments are merged.
+        Hierarchical names are not stored, an instance or a net refers to a path handle (an index in the
+        hierarchy tree) from which names are built on demand.
+    */
+    class FlatDesign {
+    public:
+        static const unsigned npos = ~0u; ///< The parent of the top path
+
+        /// Constant nets, they are the first nets of every flat design
+        enum T_Const {NET_0,     ///< Constant 0
+                      NET_1,     ///< Constant 1
+                      NET_X,     ///< Unknown value, also used for bits that do not exist (out of range index)
+                      NET_Z,     ///< High impedance
+                      NET_FIRST  ///< The first net that is not a constant
+        };
+
+        /// A connection of a net to one bit of a leaf instance port
+        struct Pin {
+            unsigned inst; ///< The leaf instance
+            unsigned port; ///< Index in Inst::get_ports()
+            unsigned bit;  ///< Index in the nets of that port (0 is the leftmost bit)
+        };
+
+        size_t          get_path_count()                      const {return _paths.size();}  ///< Returns the number of hierarchy paths, path 0 is the top module
+        unsigned        get_path_parent(const unsigned path)  const {return _paths[path].parent;} ///< Returns the parent of a path, npos for the top
+        const Inst     *get_path_inst(const unsigned path)    const {return _paths[path].inst;}   ///< Returns the instance of a path in the parent module, 0 for the top
+        const Module   *get_path_module(const unsigned path)  const {return _paths[path].module;} ///< Returns the module of a path
+        string          get_path_name(const unsigned path,const char sep='/') const;              ///< Returns the instance names from the top down to path, "" for the top
+
+        size_t          get_inst_count()                      const {return _insts.size();}      ///< Returns the number of leaf instances
+        const Inst     *get_inst(const unsigned inst)         const {return _insts[inst];}       ///< Returns a leaf instance, as found in its module
+        unsigned        get_inst_index(const unsigned inst)   const {return _inst_index[inst];}  ///< Returns the index of a leaf instance in the Module::get_instance_list() of its module
+        unsigned        get_inst_path(const unsigned inst)    const {return _inst_path[inst];}   ///< Returns the path of the module holding a leaf instance
+        string          get_inst_name(const unsigned inst,const char sep='/') const;             ///< Returns the hierarchical name of a leaf instance
+        size_t          get_port_count(const unsigned inst)   const {return _inst_ports[inst+1] - _inst_ports[inst];} ///< Same as get_inst(inst)->get_ports().size()
+        /// Returns the nets bound to a port of a leaf instance, left to right
+        const unsigned *get_port_nets(const unsigned inst,const unsigned port)  const {return _bits.data() + _port_bits[_inst_ports[inst] + port];}
+        size_t          get_port_width(const unsigned inst,const unsigned port) const {return _port_bits[_inst_ports[inst] + port + 1] - _port_bits[_inst_ports[inst] + port];}
+
+        size_t          get_net_count()                       const {return _net_pins.size() - 1;} ///< Returns the number of nets, including the constant nets
+        string          get_net_name(const unsigned net,const char sep='/') const;  ///< Returns the hierarchical name of the highest wire bit of a net (path/wire[index])
+        const Pin      *get_net_pins(const unsigned net)      const {return _pins.data() + _net_pins[net];} ///< Returns the leaf instance pins of a net
+        size_t          get_net_pin_count(const unsigned net) const {return _net_pins[net+1] - _net_pins[net];}
+        /// Returns the nets of a port of the top module (by position), left to right
+        const unsigned *get_top_port_nets(const unsigned position)  const {return _top_bits.data() + _top_ports[position];}
+        size_t          get_top_port_width(const unsigned position) const {return _top_ports[position+1] - _top_ports[position];}
+
+        ~FlatDesign();
+
+    private:
+        friend class Design;
+        struct layout;
+        struct builder;
+        struct path {
+            unsigned      parent;
+            const Inst   *inst;
+            const Module *module;
+            layout       *l;
+        };
+
+        vector<path>          _paths;
+        vector<unsigned>      _path_nets;  // First net owned by each path, ascending
+        vector<const Inst*>   _insts;
+        vector<unsigned>      _inst_index; // Leaf -> index in the instances of its module
+        vector<unsigned>      _inst_path;
+        vector<size_t>        _inst_ports; // CSR leaf -> ports
+        vector<size_t>        _port_bits;  // CSR port -> nets
+        vector<unsigned>      _bits;
+        vector<unsigned>      _net_owner;  // Net -> bit that names it, in the numbering of the paths
+        vector<size_t>        _net_pins;   // CSR net -> pins
+        vector<Pin>           _pins;
+        vector<size_t>        _top_ports;
+        vector<unsigned>      _top_bits;
+        vector<layout*>       _layouts;    // One per module below the top, shared by all its paths
+
+        FlatDesign();
+        FlatDesign(const FlatDesign&);
+        FlatDesign &operator=(const FlatDesign&);
+    };
+};
+
+#endif
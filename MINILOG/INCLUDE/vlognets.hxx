@@ -0,0 +1,99 @@
+/// @file   vlognets.hxx
+/// @brief  Connectivity index of a verilog module
+/// @author David Berthelot
+
+#ifndef VLOGNETLIST_NETS
+#define VLOGNETLIST_NETS
+
+#include <vector>
+#include "vlogobjects.hxx"
+
+using namespace std;
+
+class NameIndex;
+
+namespace VLP {
+    /// Connectivity of one module: its nets and the pins they connect
+    /** Nets are resolved by name from the wire declarations of the module and from the names used in
+        instance port expressions (an undeclared name is an implicit net). A bus is a single net: a[3] and
+        a[7:0] both connect to net a. Constants connect to no net and assignments do not merge nets.
+        The index is stored in compressed sparse row arrays: net to pins and instance to nets. Pins of a net
+        are ordered drivers first, so driver and fanout queries are constant time.
+    */
+    class NetIndex {
+    public:
+        static const unsigned npos = ~0u; ///< Returned by lookups that fail, also the instance of a module port pin
+
+        /// The direction of a pin, seen from the instance (or from inside the module for a module port)
+        enum T_Dir {D_UNKNOWN, ///< For library cell pins when no direction callback was given
+                    D_IN,      ///< For input pins
+                    D_OUT,     ///< For output pins
+                    D_INOUT    ///< For bidirectional pins
+        };
+
+        /// A connection between a net and an instance port (or a port of the module itself)
+        struct Pin {
+            unsigned inst; ///< Index of the instance in Module::get_instance_list(), npos for a port of the module
+            unsigned port; ///< Index in Inst::get_ports(), or in Module::get_port_names() for a port of the module
+            T_Dir    dir;  ///< Direction of the pin
+        };
+
+        /// Supplies the direction of library cell pins
+        /** @param model is the cell name (Inst::get_instance_module_name())
+            @param formal is the pin name, 0 when the port is position mapped
+            @param position is the index of the port in Inst::get_ports()
+        */
+        typedef T_Dir (*PinDirection)(const char *model,const char *formal,const unsigned position,void *user);
+
+        /// Builds the index of a module
+        /** @param m is the module, it must outlive the index
+            @param dir resolves the pins of instances that are not user modules, when 0 their direction is D_UNKNOWN
+            @param user is passed to dir
+            @note the pins of user module instances take the direction of the port wires, the pins of verilog
+                  primitives (and, nand, or, nor, xor, xnor, buf, not) follow the primitive terminal order
+        */
+        NetIndex(const Module *m,PinDirection dir=0,void *user=0);
+        ~NetIndex();
+
+        const Module *get_module()     const {return _module;}             ///< Returns the indexed module
+        size_t        get_net_count()  const {return _net_names.size();}   ///< Returns the number of nets
+        size_t        get_inst_count() const {return _insts.size();}       ///< Returns the number of instances
+        unsigned      find_net(const char *name) const;                    ///< Returns the net of that name, npos if there is none
+        const char   *get_net_name(const unsigned net) const {return _net_names[net];} ///< Returns the name of a net
+        const Wire   *get_net_wire(const unsigned net) const {return _net_wires[net];} ///< Returns the declaration of a net, 0 for implicit nets
+        const Inst   *get_inst(const unsigned inst)    const {return _insts[inst];}    ///< Returns an instance by index
+
+        /// Returns the pins of a net, drivers first
+        const Pin    *get_pins(const unsigned net)        const {return _pins.data() + _net_offset[net];}
+        size_t        get_pin_count(const unsigned net)   const {return _net_offset[net+1] - _net_offset[net];}
+        /// Returns the drivers of a net: instance output and inout pins, module input and inout ports
+        const Pin    *get_drivers(const unsigned net)     const {return get_pins(net);}
+        size_t        get_driver_count(const unsigned net) const {return _net_drivers[net];}
+        /// Returns the loads of a net: every pin that is not a driver, including pins of unknown direction
+        const Pin    *get_loads(const unsigned net)       const {return get_pins(net) + _net_drivers[net];}
+        size_t        get_fanout(const unsigned net)      const {return get_pin_count(net) - _net_drivers[net];}
+
+        /// Returns the nets an instance connects to, in port order (a concatenation contributes several nets)
+        const unsigned *get_inst_nets(const unsigned inst)      const {return _inst_nets.data() + _inst_offset[inst];}
+        size_t          get_inst_net_count(const unsigned inst) const {return _inst_offset[inst+1] - _inst_offset[inst];}
+
+    private:
+        const Module         *_module;
+        NameIndex            *_names;
+        vector<const char*>   _net_names;
+        vector<const Wire*>   _net_wires;
+        vector<const Inst*>   _insts;
+        vector<unsigned>      _net_offset;  // CSR net -> pins, size nets + 1
+        vector<unsigned>      _net_drivers;
+        vector<Pin>           _pins;
+        vector<unsigned>      _inst_offset; // CSR instance -> nets, size instances + 1
+        vector<unsigned>      _inst_nets;
+
+        unsigned              add_net(const char *name,const Wire *w);
+
+        NetIndex(const NetIndex&);
+        NetIndex &operator=(const NetIndex&);
+    };
+};
+
+#endif
@@ -7,11 +7,15 @@
 #ifndef VLOGNETLIST_OBJECTS
 #define VLOGNETLIST_OBJECTS
 
-#include <list>
+#include <stdint.h>
 #include <vector>
+#include <atomic>
 
 using namespace std;
 
+class LexemeTable;
+class Arena;
+
 /// The namespace encapsulating verilog parser to avoid naming conflict with your code. Details follow
 /** The following rules apply in all of the API calls in this library
  *    -# Pointers returned by APIs must not be freed (unless explicitely stated otherwise in the API documentation).
@@ -25,24 +29,51 @@ namespace VLP {
     class InstInterface;
     class Module;
     class Design;
+    class NetIndex;
+    class BitIndex;
+    class FlatDesign;
+    class StreamHandler;
 
     /// This is the main parsing function
     /** @param filename is the path to the verilog filename to be parsed
-        @param incremental when set to true, multiple call to this function keep adding to the prevously generated design, when false, the function creates a new design
+        @param incremental when set to true, multiple call to this function keep adding to the prevously generated design, when false, the function creates a new design.
+               A file that the design already holds is reloaded (see Design::reload())
+        @param use_mmap when set to true, regular files are memory mapped and scanned in place, other files (pipes, stdin) are always read through stdio
         @return a pair which contains the status (bool) and the design
         @attention the returned Design pointer must be freed to release the memory when you're finished using it
     */
-    pair<bool,Design*> parse_vlog_file(const char *filename,const bool incremental=true);
-
-    typedef list<const char *> NameList;   ///< A list of names
-    typedef pair<int,int>      Range;      ///< A range, typically used for describing wire and port ranges [from,to], from is referred to as first, to is referred to as second
-    typedef list<InstInterface*>    InstInterfaceList; ///< A list of instance interfaces
-    typedef list<Expr*>        ExprList;   ///< A list of expressions
-    typedef list<Inst*>        InstList;   ///< A list of instances
-    typedef list<Wire*>        WireList;   ///< A list of wires
-    typedef list<Assign*>      AssignList; ///< A list of assignments
-    typedef list<Object*>      ObjectList; ///< A list of objects
-    typedef list<Module*>      ModuleList; ///< A list of modules
+    pair<bool,Design*> parse_vlog_file(const char *filename,const bool incremental=true,const bool use_mmap=true);
+
+    /// Parses several files in parallel into a single new design
+    /** @param filenames are the paths to the verilog files to be parsed
+        @param nthreads is the number of parsing threads, 0 uses one thread per hardware thread
+        @param use_mmap see parse_vlog_file
+        @return a pair which contains the status (bool, false if any file failed) and the design
+        @attention the returned Design pointer must be freed to release the memory when you're finished using it
+        @note modules are added in file order, so when a module is defined twice the first definition is kept, as with parse_vlog_file
+    */
+    pair<bool,Design*> parse_vlog_files(const vector<const char*> &filenames,const unsigned nthreads=0,const bool use_mmap=true);
+
+    /// Parses a file without building a design, its objects are handed to a handler as they are parsed
+    /** @param filename is the path to the verilog file to be parsed, 0 for stdin
+        @param handler receives the modules and their objects in file order (see StreamHandler)
+        @param use_mmap see parse_vlog_file
+        @return false on syntax errors or if the file cannot be read
+        @note the memory used does not grow with the size of the file: each object is dropped once the handler has seen it
+    */
+    bool stream_vlog_file(const char *filename,StreamHandler *handler,const bool use_mmap=true);
+
+    // The lists are contiguous (std::vector) so that walking the pins of a
+    // large module stays in cache. They are only built by the parser.
+    typedef vector<const char *>     NameList;          ///< A list of names
+    typedef pair<int,int>            Range;             ///< A range, typically used for describing wire and port ranges [from,to], from is referred to as first, to is referred to as second
+    typedef vector<InstInterface*>   InstInterfaceList; ///< A list of instance interfaces
+    typedef vector<Expr*>            ExprList;          ///< A list of expressions
+    typedef vector<Inst*>            InstList;          ///< A list of instances
+    typedef vector<Wire*>            WireList;          ///< A list of wires
+    typedef vector<Assign*>          AssignList;        ///< A list of assignments
+    typedef vector<Object*>          ObjectList;        ///< A list of objects
+    typedef vector<Module*>          ModuleList;        ///< A list of modules
 
     /// This class provides common methods to all verilog objects, this class is always inherited.
     class Object {
@@ -94,15 +125,12 @@ namespace VLP {
 
         Expr(const char *name,const T_Type t);     ///< @internal
         Expr(const char *name,const int    index); ///< @internal
-        Expr(const char *name,const Range *range); ///< @internal
+        Expr(const char *name,const Range &range); ///< @internal
         ~Expr();
         
     private:
         T_Type _t;
-        const union {
-            int          _index;
-            const Range *_range;
-        };
+        Range  _range; // first is the index of T_INDEX expressions
     };
 
     /// This class represents verilog wires as well as ports (which are special types of wires)
@@ -130,11 +158,13 @@ namespace VLP {
 
         bool print() const; ///< Prints the content of this object for debugging purposes
 
-        Wire(const char *name,T_Wire t,Range *r=0); ///< @internal
+        Wire(const char *name,T_Wire t);                 ///< @internal
+        Wire(const char *name,T_Wire t,const Range &r);  ///< @internal
         ~Wire();
     private:
         T_Wire  _twire;
-        Range  *_range;
+        bool    _has_range;
+        Range   _range;
     };
 
     /// Describes a verilog assignment, note that the name of an assignment is always NULL
@@ -161,7 +191,7 @@ namespace VLP {
         const InstInterfaceList &get_ports()     const; ///< Returns the list of port interfaces for that instance
         bool print() const; ///< Prints the content of this object for debugging purposes
 
-        Inst(const char *model,const char *name,InstInterfaceList *ports); ///< @internal
+        Inst(const char *model,const char *name,InstInterfaceList *ports); ///< @internal, takes the content of ports and deletes it
         ~Inst();
     private:
         const char        *_model;
@@ -197,41 +227,118 @@ namespace VLP {
         const AssignList &get_assign_list()   const {return _assignlist;} ///< Returns the list of wires in the module
         const InstList   &get_instance_list() const {return _instlist;}   ///< Returns the list of instances in the module
         const Design     *get_design()        const;                      ///< Returns the design to which this module belongs
+        const NetIndex   *get_net_index()     const;                      ///< Returns the connectivity index of the module (see vlognets.hxx), built on the first call
+        const BitIndex   *get_bit_index()     const;                      ///< Returns the bit level connectivity index of the module (see vlogbits.hxx), built on the first call
+        const Wire       *find_wire(const char *name)                      const; ///< Returns the wire of that name, 0 if there is none
+        const Wire       *find_wire(const char *name,const size_t len)     const; ///< Same as find_wire(name) for a name of len characters, not necessarily '\0' terminated
+        const Inst       *find_instance(const char *name)                  const; ///< Returns the instance of that name, 0 if there is none
+        const Inst       *find_instance(const char *name,const size_t len) const; ///< Same as find_instance(name) for a name of len characters, not necessarily '\0' terminated
 
         bool print() const; ///< Prints the content of this object for debugging purposes
 
-        Module(const char *name,NameList *nl);  ///< @internal
+        Module(const char *name,NameList *nl);  ///< @internal, takes the content of nl and deletes it
         ~Module();
 
         bool add_objects(ObjectList *ol); ///< @internal
         bool add_wire(Wire *w);           ///< @internal
         bool add_assign(Assign *a);       ///< @internal
         bool add_inst(Inst *i);           ///< @internal
+        void drop_net_index();            ///< @internal, get_net_index() builds it again
 
     private:
         NameList     _namelist;
         WireList     _wirelist;
         AssignList   _assignlist;
         InstList     _instlist;
+
+        struct names;
+        mutable atomic<NetIndex*> _nets;
+        mutable atomic<BitIndex*> _bits;
+        mutable atomic<names*>    _names;
+        const names              *get_names() const;
     };
 
     /// This class is a container that stores all the modules that are part of a design
+    /** The const methods of a design and of the objects it holds never modify the design (lookups do not
+        insert, indexes are built once on first use), so any number of threads may query a design at the same
+        time. They must not run while the design is extended by an incremental parse_vlog_file() or reload().
+        The design remembers the file each module was parsed from, and a fingerprint of its content.
+    */
     class Design : public Object {
     public:
         const ModuleList &get_modules() const;                 ///< Returns the list of modules in the design
         const Module     *get_module(const char *name) const;  ///< Finds the module with the name specified as argument
+        const Module     *get_module(const char *name,const size_t len) const; ///< Same as get_module(name) for a name of len characters, not necessarily '\0' terminated
         const NameList    find_top_modules() const;            ///< Heuristically determines the top module(s)
+        /// Flattens the design below a module (see vlogflat.hxx)
+        /** @param top is the top module, one of get_modules()
+            @param nthreads is the number of threads elaborating the hierarchy, 0 uses one thread per hardware thread
+            @return the flat design, 0 if top is not in the design or is recursively instantiated
+            @attention the returned FlatDesign pointer must be freed to release the memory when you're finished using it
+        */
+        FlatDesign       *flatten(const Module *top,const unsigned nthreads=0) const;
+
+        /// Saves the design in a binary snapshot, see load_snapshot()
+        /** @return false if the file cannot be written
+        */
+        bool              save_snapshot(const char *path) const;
+        /// Loads a design saved by save_snapshot(), without parsing
+        /** @return the design, 0 if path is not a snapshot of the current version or is corrupted
+            @attention the returned Design pointer must be freed to release the memory when you're finished using it
+            @note a snapshot is only readable on machines of the same byte order as the writer
+        */
+        static Design    *load_snapshot(const char *path);
+
+        /// Parses a file again and replaces the modules it defined by the new ones
+        /** The file is skipped, without being parsed, when its content is the one previously parsed. The
+            connectivity indexes of the modules that instantiate a replaced module are dropped and built again on
+            their next get_net_index(). The modules of the file are deleted: pointers to them, and flat designs
+            built from the design, must not be used after the reload.
+            A file the design doesn't hold is added as by an incremental parse_vlog_file().
+            @param filename is the path of the file, as given to the parse, 0 for stdin which is always parsed and added
+            @param use_mmap see parse_vlog_file
+            @return false on syntax errors or if the file cannot be read. The design then keeps the previous modules
+                    of a file it held, the modules of a new file parsed before the error are added
+            @note a module defined in several files belongs to the first one parsed. The other definitions are kept
+                  aside: when the file of the module is reloaded without it, the next definition, in parse order, takes over
+            @note a file that can't be memory mapped, or with use_mmap false, is fingerprinted as it is scanned: it is parsed
+                  even when unchanged, and the modules are dropped when the fingerprint matches
+        */
+        bool              reload(const char *filename,const bool use_mmap=true);
+        /// Returns the file the module was parsed from, 0 for stdin or a module loaded from a snapshot
+        const char       *get_filename(const Module *m) const;
 
         bool              print() const; ///< Prints the content of this object for debugging purposes
 
         Design();                                              ///< @internal
         ~Design();
         bool              add_module(Module *m);               ///< @internal
+        /// @internal Takes the modules parsed from filename and the arena holding their objects, in place of a previous parse
+        void              add_source(const char *filename,const uint64_t fingerprint,ModuleList *modules,Arena *arena);
+        LexemeTable      *get_lexemes() const;                 ///< @internal
+        Arena            *get_arena()   const;                 ///< @internal
 
     private:
+        struct source;
         struct data;
         data  *_data;
     };
+
+    /// Receives the objects of a file parsed by stream_vlog_file(), derive from it and override the callbacks of interest
+    /** The objects and names are transient views: they are only valid during the call. The objects have no
+        parent, so get_parent_module() returns 0 and get_instance_module() must not be called.
+        The wires declared in a module header (verilog 2001) come right after on_module_begin().
+    */
+    class StreamHandler {
+    public:
+        virtual ~StreamHandler() {}
+
+        virtual void on_module_begin(const char *name,const NameList &ports) {} ///< A module starts, ports are the names of its ports
+        virtual void on_wire(const Wire *w)                                  {} ///< A wire or port declaration, one call per declared name
+        virtual void on_assign(const Assign *a)                              {} ///< An assignment
+        virtual void on_instance(const Inst *i)                              {} ///< A cell instance
+        virtual void on_module_end(const char *name)                         {} ///< The module named name ends
+    };
 };
 
 #endif
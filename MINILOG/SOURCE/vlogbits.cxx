@@ -0,0 +1,292 @@
+// Verilog netlist reader
+// Author: David Berthelot
+
+#include <stdlib.h>
+#include <algorithm>
+#include "vlogbits.hxx"
+#include "NameIndex.hxx"
+
+// The wires are numbered first, the declared ones then the implicit ones
+// in order of use. The ports of the instances, of the module and the sides
+// of the assignments are then expanded into one array of bits, the
+// instance ports first so that a port is found by its index. The pins of
+// the wire bits are counted, then bucketed by bit.
+
+// [size]'[s]b<digits>, unsized constants are 32 bits wide. A constant
+// shorter than its size is extended with 0, or with x/z when its leftmost
+// digit is x/z.
+static void append_constant_bits(const char *text,vector<unsigned> &bits)
+{
+    const char       *q      = text;
+    vector<unsigned>  digits;
+    unsigned          size   = 32;
+
+    if (*q != '\'') {
+        size = static_cast<unsigned>(strtoul(q,0,10));
+        while (*q && *q != '\'') {
+            ++q;
+        }
+    }
+    while (*q && *q != 'b' && *q != 'B') {
+        ++q;
+    }
+    for (q = *q ? q + 1 : q; *q; ++q) {
+        switch (*q) {
+        case '0':                     digits.push_back(VLP::BitIndex::BIT_0); break;
+        case '1':                     digits.push_back(VLP::BitIndex::BIT_1); break;
+        case 'x': case 'X':           digits.push_back(VLP::BitIndex::BIT_X); break;
+        case 'z': case 'Z': case '?': digits.push_back(VLP::BitIndex::BIT_Z); break;
+        default:                      break;
+        }
+    }
+    const unsigned fill = !digits.empty() && digits[0] >= VLP::BitIndex::BIT_X ? digits[0] : static_cast<unsigned>(VLP::BitIndex::BIT_0);
+
+    for (size_t x=digits.size(); x<size; ++x) {
+        bits.push_back(fill);
+    }
+    for (size_t x=digits.size() > size ? digits.size() - size : 0; x<digits.size(); ++x) {
+        bits.push_back(digits[x]);
+    }
+}
+
+// Appends the bits of a port actual, a concatenation or a single expression
+static void append_actual_bits(const VLP::BitIndex *b,const VLP::InstInterface *ii,vector<unsigned> &bits)
+{
+    if (ii->is_actual_conc()) {
+        const VLP::ExprList *l = ii->get_actual_conc();
+
+        for (VLP::ExprList::const_iterator e=l->begin(); e!=l->end(); ++e) {
+            b->append_bits(*e,bits);
+        }
+    } else {
+        b->append_bits(ii->get_actual_expr(),bits);
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Class BitIndex
+//-----------------------------------------------------------------------------
+const unsigned VLP::BitIndex::npos;
+
+VLP::BitIndex::BitIndex(const Module *m):
+    _module(m),_index(new NameIndex()),_port_index(new NameIndex())
+{
+    const WireList   &wl = m->get_wire_list();
+    const NameList   &pl = m->get_port_names();
+    const AssignList &al = m->get_assign_list();
+    const InstList   &il = m->get_instance_list();
+
+    _base.push_back(BIT_FIRST);
+    _index->reserve(wl.size());
+    for (WireList::const_iterator x=wl.begin(); x!=wl.end(); ++x) {
+        add_wire((*x)->get_name(),*x,(*x)->get_range());
+    }
+    for (AssignList::const_iterator x=al.begin(); x!=al.end(); ++x) {
+        add_expr((*x)->get_lhs());
+        add_expr((*x)->get_rhs());
+    }
+    _inst_ports.reserve(il.size() + 1);
+    _inst_ports.push_back(0);
+    for (InstList::const_iterator x=il.begin(); x!=il.end(); ++x) {
+        const InstInterfaceList &ports = (*x)->get_ports();
+
+        for (InstInterfaceList::const_iterator p=ports.begin(); p!=ports.end(); ++p) {
+            if ((*p)->is_actual_conc()) {
+                const ExprList *l = (*p)->get_actual_conc();
+
+                for (ExprList::const_iterator e=l->begin(); e!=l->end(); ++e) {
+                    add_expr(*e);
+                }
+            } else {
+                add_expr((*p)->get_actual_expr());
+            }
+        }
+        _inst_ports.push_back(_inst_ports.back() + static_cast<unsigned>(ports.size()));
+    }
+
+    _module_ports = _inst_ports.back();
+    _assigns      = _module_ports + static_cast<unsigned>(pl.size());
+    _port_bits.reserve(_assigns + 2 * al.size() + 1);
+    _port_bits.push_back(0);
+    for (InstList::const_iterator x=il.begin(); x!=il.end(); ++x) {
+        const InstInterfaceList &ports = (*x)->get_ports();
+
+        for (InstInterfaceList::const_iterator p=ports.begin(); p!=ports.end(); ++p) {
+            append_actual_bits(this,*p,_bits);
+            _port_bits.push_back(static_cast<unsigned>(_bits.size()));
+        }
+    }
+    for (NameList::const_iterator x=pl.begin(); x!=pl.end(); ++x) {
+        const unsigned w = find_wire(*x);
+
+        _port_index->insert(*x,static_cast<unsigned>(x - pl.begin()));
+        if (w == npos) {
+            _bits.push_back(BIT_X);
+        } else {
+            for (unsigned b=_base[w]; b<_base[w+1]; ++b) {
+                _bits.push_back(b);
+            }
+        }
+        _port_bits.push_back(static_cast<unsigned>(_bits.size()));
+    }
+    for (AssignList::const_iterator x=al.begin(); x!=al.end(); ++x) {
+        append_bits((*x)->get_lhs(),_bits);
+        _port_bits.push_back(static_cast<unsigned>(_bits.size()));
+        append_bits((*x)->get_rhs(),_bits);
+        _port_bits.push_back(static_cast<unsigned>(_bits.size()));
+    }
+
+    // Pins of the wire bits: module ports first, then instance ports
+    const unsigned nwire_bits = get_bit_count() - BIT_FIRST;
+
+    _bit_pins.assign(nwire_bits + 1,0);
+    for (size_t k=0; k<_port_bits[_assigns]; ++k) {
+        if (!is_constant(_bits[k])) {
+            ++_bit_pins[_bits[k] - BIT_FIRST + 1];
+        }
+    }
+    for (unsigned b=0; b<nwire_bits; ++b) {
+        _bit_pins[b+1] += _bit_pins[b];
+    }
+    _pins.resize(_bit_pins.back());
+
+    vector<unsigned> fill(_bit_pins.begin(),_bit_pins.end() - 1);
+
+    for (unsigned p=0; p<pl.size(); ++p) {
+        const unsigned port = _module_ports + p;
+
+        for (unsigned k=_port_bits[port]; k<_port_bits[port+1]; ++k) {
+            if (!is_constant(_bits[k])) {
+                const Pin pin = {npos,p,k - _port_bits[port]};
+
+                _pins[fill[_bits[k] - BIT_FIRST]++] = pin;
+            }
+        }
+    }
+    for (unsigned i=0; i<il.size(); ++i) {
+        for (unsigned port=_inst_ports[i]; port<_inst_ports[i+1]; ++port) {
+            for (unsigned k=_port_bits[port]; k<_port_bits[port+1]; ++k) {
+                if (!is_constant(_bits[k])) {
+                    const Pin pin = {i,port - _inst_ports[i],k - _port_bits[port]};
+
+                    _pins[fill[_bits[k] - BIT_FIRST]++] = pin;
+                }
+            }
+        }
+    }
+}
+
+VLP::BitIndex::~BitIndex()
+{
+    delete _index;
+    delete _port_index;
+}
+
+// A wire declared twice (output [3:0] o; wire [3:0] o;) keeps its first range
+void VLP::BitIndex::add_wire(const char *name,const Wire *w,const Range *r)
+{
+    const unsigned x = static_cast<unsigned>(_names.size());
+
+    if (_index->insert(name,x) != x) {
+        return;
+    }
+    _names.push_back(name);
+    _wires.push_back(w);
+    _range.push_back(r ? *r : Range(-1,-1));
+    _base.push_back(_base.back() + (r ? abs(r->first - r->second) + 1 : 1));
+}
+
+void VLP::BitIndex::add_expr(const Expr *e)
+{
+    if (e && e->get_type() != Expr::T_CONSTANT && find_wire(e->get_name()) == npos) {
+        add_wire(e->get_name(),0,0);
+    }
+}
+
+unsigned VLP::BitIndex::find_wire(const char *name) const
+{
+    const unsigned w = _index->find(name);
+
+    return w == NameIndex::npos ? npos : w;
+}
+
+unsigned VLP::BitIndex::find_port(const char *name) const
+{
+    const unsigned p = _port_index->find(name);
+
+    return p == NameIndex::npos ? npos : p;
+}
+
+unsigned VLP::BitIndex::find_bit(const unsigned w,const int index) const
+{
+    const Range &r = _range[w];
+
+    if (r.first < 0) {
+        return index == 0 ? _base[w] : static_cast<unsigned>(BIT_X);
+    }
+    const int lo = min(r.first,r.second);
+    const int hi = max(r.first,r.second);
+
+    if (index < lo || index > hi) {
+        return BIT_X;
+    }
+    return _base[w] + (r.first >= r.second ? r.first - index : index - r.first);
+}
+
+void VLP::BitIndex::append_bits(const Expr *e,vector<unsigned> &bits) const
+{
+    if (!e) {
+        return;
+    }
+    if (e->get_type() == Expr::T_CONSTANT) {
+        append_constant_bits(e->get_name(),bits);
+        return;
+    }
+    const unsigned w = find_wire(e->get_name());
+
+    if (w == npos) {
+        bits.push_back(BIT_X);
+        return;
+    }
+    switch (e->get_type()) {
+    case Expr::T_INDEX:
+        bits.push_back(find_bit(w,e->get_index()));
+        break;
+    case Expr::T_RANGE: {
+        const Range *r    = e->get_range();
+        const int    step = r->first >= r->second ? -1 : 1;
+
+        for (int i=r->first; ; i+=step) {
+            bits.push_back(find_bit(w,i));
+            if (i == r->second) {
+                break;
+            }
+        }
+        break;
+    }
+    default:
+        for (unsigned b=_base[w]; b<_base[w+1]; ++b) {
+            bits.push_back(b);
+        }
+        break;
+    }
+}
+
+unsigned VLP::BitIndex::get_wire_of(const unsigned bit) const
+{
+    return static_cast<unsigned>(upper_bound(_base.begin(),_base.end(),bit) - _base.begin()) - 1;
+}
+
+int VLP::BitIndex::get_bit_index(const unsigned bit) const
+{
+    const unsigned w = get_wire_of(bit);
+    const Range   &r = _range[w];
+
+    if (r.first < 0) {
+        return -1;
+    }
+    const int offset = static_cast<int>(bit - _base[w]);
+
+    return r.first >= r.second ? r.first - offset : r.first + offset;
+}
@@ -0,0 +1,534 @@
+// Verilog netlist reader
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <algorithm>
+#include "vlogflat.hxx"
+#include "vlogbits.hxx"
+#include "NameIndex.hxx"
+#include "ThreadPool.hxx"
+
+// Flattening is done in three steps:
+//  - a layout is built for every module below the top: its leaf instances
+//    and the port bindings of its child instances, read from the bit index
+//    of the module. The layouts are shared by all the instances of a module.
+//  - the sizes of each subtree are summed up, so that every path knows in
+//    advance where its nets, leaves and ports go in the flat arrays. Paths
+//    are laid out in preorder.
+//  - the paths are elaborated, independent subtrees in parallel since they
+//    write to disjoint parts of the flat arrays. The nets bound to ports and
+//    assignments are then merged.
+
+typedef pair<unsigned,unsigned> bit_pair;
+
+struct VLP::FlatDesign::layout {
+    struct child {
+        unsigned  inst;      // Index in the instance list
+        unsigned  module;    // Index in the design modules, then resolved to l
+        layout   *l;
+    };
+
+    const Module      *module;
+    const BitIndex    &bits;
+    vector<unsigned>   leaves;      // Index of the leaf instances in the instance list
+    vector<size_t>     leaf_ports;  // CSR leaf -> ports
+    vector<size_t>     port_bits;   // CSR port -> bits
+    vector<unsigned>   leaf_bits;
+    vector<child>      children;
+    vector<size_t>     child_binds; // CSR child -> binds
+    vector<bit_pair>   binds;       // (bit of the child,bit of this module)
+    vector<bit_pair>   aliases;     // Assignments
+
+    // Sizes of the subtree below an instance of this module
+    size_t             paths,nets,nleaves,ports,nbits,naliases;
+    int                state;       // 0: not summed, 1: being summed, 2: summed
+
+    layout(const Module *m):module(m),bits(*m->get_bit_index()),paths(0),nets(0),nleaves(0),ports(0),nbits(0),naliases(0),state(0) {}
+
+    void find_children(const NameIndex &modules);
+    void bind(const vector<layout*> &layouts);
+    void bind_once(const size_t first);
+    bool sum();
+};
+
+// Where a path goes in the flat arrays, and the nets of its bits
+struct VLP::FlatDesign::builder {
+    struct item {
+        layout           *l;
+        unsigned          path,parent;
+        const Inst       *inst;
+        size_t            net,leaf,port,bit,alias;
+        vector<unsigned>  map;          // Bit of the module -> net
+    };
+
+    FlatDesign        *fd;
+    vector<bit_pair>   aliases;
+    vector<char>       dead;            // Nets of bits bound to a port in the parent
+
+    builder(FlatDesign *f):fd(f) {}
+
+    void expand(const item &it,vector<item> *next);
+    void merge_nets(ThreadPool &pool);
+    void index_pins();
+};
+
+// Pairs the bits of two vectors aligned on the right (lsb), as verilog does
+// when the widths differ
+static void pair_bits(const unsigned *a,const size_t na,const unsigned *b,const size_t nb,vector<bit_pair> &pairs)
+{
+    const size_t n = min(na,nb);
+
+    for (size_t k=1; k<=n; ++k) {
+        pairs.push_back(bit_pair(a[na-k],b[nb-k]));
+    }
+}
+
+void VLP::FlatDesign::layout::find_children(const NameIndex &modules)
+{
+    const InstList &il = module->get_instance_list();
+
+    for (size_t i=0; i<il.size(); ++i) {
+        const unsigned mx = modules.find(il[i]->get_instance_module_name());
+
+        if (mx != NameIndex::npos) {
+            child c = {static_cast<unsigned>(i),mx,0};
+
+            children.push_back(c);
+        }
+    }
+}
+
+// Called once the layouts of every child module exist
+void VLP::FlatDesign::layout::bind(const vector<layout*> &layouts)
+{
+    const InstList   &il = module->get_instance_list();
+    const AssignList &al = module->get_assign_list();
+    size_t            next = 0;
+
+    leaf_ports.push_back(0);
+    port_bits.push_back(0);
+    child_binds.push_back(0);
+    for (size_t i=0; i<il.size(); ++i) {
+        const InstInterfaceList &ports = il[i]->get_ports();
+
+        if (next < children.size() && children[next].inst == i) {
+            child             &c  = children[next++];
+            const BitIndex    &cb = layouts[c.module]->bits;
+
+            const size_t       first = binds.size();
+
+            c.l = layouts[c.module];
+            for (size_t p=0; p<ports.size(); ++p) {
+                const char    *formal   = ports[p]->get_formal();
+                const unsigned position = formal ? cb.find_port(formal) : static_cast<unsigned>(p);
+
+                if (formal && position == BitIndex::npos) {
+                    printf("VLP-005: Module %s has no port %s (instance %s)\n",c.l->module->get_name(),formal,il[i]->get_name());
+                    continue;
+                }
+                if (position < c.l->module->get_port_names().size()) {
+                    pair_bits(cb.get_module_port_bits(position),cb.get_module_port_width(position),
+                              bits.get_port_bits(i,p),bits.get_port_width(i,p),binds);
+                }
+            }
+            bind_once(first);
+            child_binds.push_back(binds.size());
+        } else {
+            leaves.push_back(static_cast<unsigned>(i));
+            for (size_t p=0; p<ports.size(); ++p) {
+                leaf_bits.insert(leaf_bits.end(),bits.get_port_bits(i,p),bits.get_port_bits(i,p) + bits.get_port_width(i,p));
+                port_bits.push_back(leaf_bits.size());
+            }
+            leaf_ports.push_back(port_bits.size() - 1);
+        }
+    }
+    for (unsigned x=0; x<al.size(); ++x) {
+        pair_bits(bits.get_lhs_bits(x),bits.get_lhs_width(x),bits.get_rhs_bits(x),bits.get_rhs_width(x),aliases);
+    }
+}
+
+// A bit of a child bound twice (one wire on two ports) keeps its first
+// binding, the parent bits of the others are merged into it. Constant bits
+// of the child (undeclared ports) are not bound.
+void VLP::FlatDesign::layout::bind_once(const size_t first)
+{
+    size_t n = first;
+
+    sort(binds.begin() + first,binds.end());
+    for (size_t k=first; k<binds.size(); ++k) {
+        if (BitIndex::is_constant(binds[k].first)) {
+            continue;
+        }
+        if (n > first && binds[n-1].first == binds[k].first) {
+            aliases.push_back(bit_pair(binds[n-1].second,binds[k].second));
+        } else {
+            binds[n++] = binds[k];
+        }
+    }
+    binds.resize(n);
+}
+
+// Returns false on recursive instantiation
+bool VLP::FlatDesign::layout::sum()
+{
+    if (state != 0) {
+        if (state == 1) {
+            printf("VLP-004: Recursive instantiation of module %s\n",module->get_name());
+        }
+        return state == 2;
+    }
+    state    = 1;
+    paths    = 1;
+    nets     = bits.get_bit_count() - BitIndex::BIT_FIRST;
+    nleaves  = leaves.size();
+    ports    = port_bits.size() - 1;
+    nbits    = leaf_bits.size();
+    naliases = aliases.size();
+    for (vector<child>::const_iterator c=children.begin(); c!=children.end(); ++c) {
+        if (!c->l->sum()) {
+            return false;
+        }
+        paths    += c->l->paths;
+        nets     += c->l->nets;
+        nleaves  += c->l->nleaves;
+        ports    += c->l->ports;
+        nbits    += c->l->nbits;
+        naliases += c->l->naliases;
+    }
+    state = 2;
+    return true;
+}
+
+// Fills the part of the flat arrays that belongs to the path of it. The
+// children are either elaborated right away (next == 0) or queued.
+void VLP::FlatDesign::builder::expand(const item &it,vector<item> *next)
+{
+    const layout   *l  = it.l;
+    const InstList &il = l->module->get_instance_list();
+    const unsigned  p  = it.path;
+
+    fd->_paths[p].parent = it.parent;
+    fd->_paths[p].inst   = it.inst;
+    fd->_paths[p].module = l->module;
+    fd->_paths[p].l      = it.l;
+    fd->_path_nets[p]    = static_cast<unsigned>(it.net);
+    for (size_t j=0; j<l->leaves.size(); ++j) {
+        fd->_insts[it.leaf + j]      = il[l->leaves[j]];
+        fd->_inst_index[it.leaf + j] = l->leaves[j];
+        fd->_inst_path[it.leaf + j]  = p;
+        fd->_inst_ports[it.leaf + j] = it.port + l->leaf_ports[j];
+    }
+    for (size_t k=0; k+1<l->port_bits.size(); ++k) {
+        fd->_port_bits[it.port + k] = it.bit + l->port_bits[k];
+    }
+    for (size_t x=0; x<l->leaf_bits.size(); ++x) {
+        fd->_bits[it.bit + x] = it.map[l->leaf_bits[x]];
+    }
+    for (size_t x=0; x<l->aliases.size(); ++x) {
+        aliases[it.alias + x] = bit_pair(it.map[l->aliases[x].first],it.map[l->aliases[x].second]);
+    }
+
+    item c;
+
+    c.path  = p + 1;
+    c.net   = it.net   + l->bits.get_bit_count() - BitIndex::BIT_FIRST;
+    c.leaf  = it.leaf  + l->leaves.size();
+    c.port  = it.port  + l->port_bits.size() - 1;
+    c.bit   = it.bit   + l->leaf_bits.size();
+    c.alias = it.alias + l->aliases.size();
+    for (size_t x=0; x<l->children.size(); ++x) {
+        const layout::child &ch = l->children[x];
+
+        c.l      = ch.l;
+        c.parent = p;
+        c.inst   = il[ch.inst];
+        c.map.resize(ch.l->bits.get_bit_count());
+        for (unsigned b=0; b<BitIndex::BIT_FIRST; ++b) {
+            c.map[b] = b;
+        }
+        for (unsigned b=BitIndex::BIT_FIRST; b<c.map.size(); ++b) {
+            c.map[b] = static_cast<unsigned>(c.net + b - BitIndex::BIT_FIRST);
+        }
+        for (size_t k=l->child_binds[x]; k<l->child_binds[x+1]; ++k) {
+            const unsigned cb = l->binds[k].first;
+
+            dead[c.net + cb - BitIndex::BIT_FIRST] = 1;
+            c.map[cb] = it.map[l->binds[k].second];
+        }
+        if (next) {
+            next->push_back(c);
+        } else {
+            expand(c,0);
+        }
+        c.path  += ch.l->paths;
+        c.net   += ch.l->nets;
+        c.leaf  += ch.l->nleaves;
+        c.port  += ch.l->ports;
+        c.bit   += ch.l->nbits;
+        c.alias += ch.l->naliases;
+    }
+}
+
+static unsigned find_root(vector<unsigned> &uf,unsigned x)
+{
+    while (uf[x] != x) {
+        uf[x] = uf[uf[x]];
+        x     = uf[x];
+    }
+    return x;
+}
+
+// Merges the aliased nets and numbers the remaining ones densely. The root
+// of merged nets is the lowest net, that is a constant or the net of the
+// highest path.
+void VLP::FlatDesign::builder::merge_nets(ThreadPool &pool)
+{
+    vector<unsigned> uf(dead.size());
+
+    for (size_t x=0; x<uf.size(); ++x) {
+        uf[x] = static_cast<unsigned>(x);
+    }
+    for (vector<bit_pair>::const_iterator a=aliases.begin(); a!=aliases.end(); ++a) {
+        const unsigned ra = find_root(uf,a->first);
+        const unsigned rb = find_root(uf,a->second);
+
+        uf[max(ra,rb)] = min(ra,rb);
+    }
+
+    // Roots are numbered before the nets merged into them
+    vector<unsigned> number(uf.size());
+
+    for (unsigned x=0; x<uf.size(); ++x) {
+        const unsigned r = find_root(uf,x);
+
+        if (r == x && (x < NET_FIRST || !dead[x])) {
+            number[x] = static_cast<unsigned>(fd->_net_owner.size());
+            fd->_net_owner.push_back(x);
+        } else if (!dead[x]) {
+            number[x] = number[r];
+        }
+    }
+
+    const size_t chunk   = 1 << 16;
+    const size_t nchunks = (fd->_bits.size() + chunk - 1) / chunk;
+
+    pool.run(nchunks,[&](size_t c) {
+        const size_t end = min(fd->_bits.size(),(c + 1) * chunk);
+
+        for (size_t x=c*chunk; x<end; ++x) {
+            fd->_bits[x] = number[fd->_bits[x]];
+        }
+    });
+    for (size_t x=0; x<fd->_top_bits.size(); ++x) {
+        fd->_top_bits[x] = number[fd->_top_bits[x]];
+    }
+}
+
+void VLP::FlatDesign::builder::index_pins()
+{
+    const size_t nnets = fd->_net_owner.size();
+
+    fd->_net_pins.assign(nnets + 1,0);
+    for (size_t x=0; x<fd->_bits.size(); ++x) {
+        ++fd->_net_pins[fd->_bits[x] + 1];
+    }
+    for (size_t n=0; n<nnets; ++n) {
+        fd->_net_pins[n + 1] += fd->_net_pins[n];
+    }
+
+    vector<size_t> pos(fd->_net_pins.begin(),fd->_net_pins.end() - 1);
+
+    fd->_pins.resize(fd->_bits.size());
+    for (size_t i=0; i<fd->_insts.size(); ++i) {
+        for (size_t p=fd->_inst_ports[i]; p<fd->_inst_ports[i+1]; ++p) {
+            for (size_t b=fd->_port_bits[p]; b<fd->_port_bits[p+1]; ++b) {
+                Pin &pin = fd->_pins[pos[fd->_bits[b]]++];
+
+                pin.inst = static_cast<unsigned>(i);
+                pin.port = static_cast<unsigned>(p - fd->_inst_ports[i]);
+                pin.bit  = static_cast<unsigned>(b - fd->_port_bits[p]);
+            }
+        }
+    }
+}
+
+VLP::FlatDesign::FlatDesign()
+{
+}
+
+VLP::FlatDesign::~FlatDesign()
+{
+    for (vector<layout*>::const_iterator x=_layouts.begin(); x!=_layouts.end(); ++x) {
+        delete *x;
+    }
+}
+
+VLP::FlatDesign *VLP::Design::flatten(const Module *top,const unsigned nthreads) const
+{
+    typedef FlatDesign::layout  layout;
+    typedef FlatDesign::builder builder;
+
+    const ModuleList  &ml = get_modules();
+    NameIndex          modules;
+    vector<layout*>    layouts(ml.size(),static_cast<layout*>(0));
+    vector<char>       queued(ml.size(),0);
+    vector<unsigned>   wave;
+    ThreadPool         pool(nthreads);
+    FlatDesign        *fd = new FlatDesign();
+
+    modules.reserve(ml.size());
+    for (size_t x=0; x<ml.size(); ++x) {
+        modules.insert(ml[x]->get_name(),static_cast<unsigned>(x));
+        if (ml[x] == top) {
+            wave.push_back(static_cast<unsigned>(x));
+            queued[x] = 1;
+        }
+    }
+    if (wave.empty()) {
+        delete fd;
+        return 0;
+    }
+
+    // Layouts of the modules below the top, one level of new modules at a time
+    while (!wave.empty()) {
+        vector<unsigned> next;
+
+        for (size_t x=0; x<wave.size(); ++x) {
+            layouts[wave[x]] = new layout(ml[wave[x]]);
+            fd->_layouts.push_back(layouts[wave[x]]);
+        }
+        pool.run(wave.size(),[&](size_t x) {layouts[wave[x]]->find_children(modules);});
+        for (size_t x=0; x<wave.size(); ++x) {
+            const vector<layout::child> &ch = layouts[wave[x]]->children;
+
+            for (size_t c=0; c<ch.size(); ++c) {
+                if (!queued[ch[c].module]) {
+                    queued[ch[c].module] = 1;
+                    next.push_back(ch[c].module);
+                }
+            }
+        }
+        wave.swap(next);
+    }
+    pool.run(fd->_layouts.size(),[&](size_t x) {fd->_layouts[x]->bind(layouts);});
+
+    layout *root = fd->_layouts[0];
+
+    if (!root->sum()) {
+        delete fd;
+        return 0;
+    }
+    if (FlatDesign::NET_FIRST + root->nets >= FlatDesign::npos || root->nbits >= FlatDesign::npos) {
+        printf("VLP-006: Module %s is too large to flatten\n",top->get_name());
+        delete fd;
+        return 0;
+    }
+
+    builder b(fd);
+
+    fd->_paths.resize(root->paths);
+    fd->_path_nets.resize(root->paths);
+    fd->_insts.resize(root->nleaves);
+    fd->_inst_index.resize(root->nleaves);
+    fd->_inst_path.resize(root->nleaves);
+    fd->_inst_ports.resize(root->nleaves + 1);
+    fd->_inst_ports[root->nleaves] = root->ports;
+    fd->_port_bits.resize(root->ports + 1);
+    fd->_port_bits[root->ports] = root->nbits;
+    fd->_bits.resize(root->nbits);
+    b.aliases.resize(root->naliases);
+    b.dead.assign(FlatDesign::NET_FIRST + root->nets,0);
+
+    builder::item t;
+
+    t.l      = root;
+    t.path   = 0;
+    t.parent = FlatDesign::npos;
+    t.inst   = 0;
+    t.net    = FlatDesign::NET_FIRST;
+    t.leaf   = t.port = t.bit = t.alias = 0;
+    t.map.resize(root->bits.get_bit_count());
+    for (unsigned x=0; x<t.map.size(); ++x) {
+        t.map[x] = x < BitIndex::BIT_FIRST ? x : x - BitIndex::BIT_FIRST + FlatDesign::NET_FIRST;
+    }
+    fd->_top_ports.push_back(0);
+    for (unsigned x=0; x<top->get_port_names().size(); ++x) {
+        const unsigned *bits = root->bits.get_module_port_bits(x);
+
+        for (size_t k=0; k<root->bits.get_module_port_width(x); ++k) {
+            fd->_top_bits.push_back(t.map[bits[k]]);
+        }
+        fd->_top_ports.push_back(fd->_top_bits.size());
+    }
+
+    // Expand the top levels until there are enough subtrees to keep the
+    // threads busy, then elaborate each subtree on its own
+    vector<builder::item> frontier(1,t);
+
+    while (!frontier.empty() && frontier.size() < 4 * pool.size()) {
+        vector<builder::item> next;
+
+        for (size_t x=0; x<frontier.size(); ++x) {
+            b.expand(frontier[x],&next);
+        }
+        frontier.swap(next);
+    }
+    pool.run(frontier.size(),[&](size_t x) {b.expand(frontier[x],0);});
+
+    b.merge_nets(pool);
+    b.index_pins();
+    return fd;
+}
+
+string VLP::FlatDesign::get_path_name(const unsigned path,const char sep) const
+{
+    vector<const char*> names;
+    string              s;
+
+    for (unsigned p=path; p!=0; p=_paths[p].parent) {
+        names.push_back(_paths[p].inst->get_name());
+    }
+    for (size_t x=names.size(); x>0; --x) {
+        s += names[x-1];
+        if (x > 1) {
+            s += sep;
+        }
+    }
+    return s;
+}
+
+string VLP::FlatDesign::get_inst_name(const unsigned inst,const char sep) const
+{
+    string s = get_path_name(_inst_path[inst],sep);
+
+    if (!s.empty()) {
+        s += sep;
+    }
+    return s + _insts[inst]->get_name();
+}
+
+string VLP::FlatDesign::get_net_name(const unsigned net,const char sep) const
+{
+    static const char *const constants[] = {"1'b0","1'b1","1'bx","1'bz"};
+    const unsigned           owner       = _net_owner[net];
+
+    if (owner < NET_FIRST) {
+        return constants[owner];
+    }
+    const unsigned    p   = static_cast<unsigned>(upper_bound(_path_nets.begin(),_path_nets.end(),owner) - _path_nets.begin()) - 1;
+    const BitIndex   &mb  = _paths[p].l->bits;
+    const unsigned    bit = owner - _path_nets[p] + BitIndex::BIT_FIRST;
+    const int         idx = mb.get_bit_index(bit);
+    string            s   = get_path_name(p,sep);
+    char              buf[16];
+
+    if (!s.empty()) {
+        s += sep;
+    }
+    s += mb.get_wire_name(mb.get_wire_of(bit));
+    if (idx >= 0) {
+        snprintf(buf,sizeof(buf),"[%d]",idx);
+        s += buf;
+    }
+    return s;
+}
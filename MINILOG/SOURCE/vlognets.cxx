@@ -0,0 +1,197 @@
+// Verilog netlist reader
+// Author: David Berthelot
+
+#include <string.h>
+#include "vlognets.hxx"
+#include "NameIndex.hxx"
+
+// A connection found while walking the instances, before it is sorted by net
+struct connection {
+    unsigned          net;
+    VLP::NetIndex::Pin pin;
+};
+
+static VLP::NetIndex::T_Dir wire_dir(const VLP::Wire *w)
+{
+    switch (w->get_type()) {
+    case VLP::Wire::W_IN:    return VLP::NetIndex::D_IN;
+    case VLP::Wire::W_OUT:   return VLP::NetIndex::D_OUT;
+    case VLP::Wire::W_INOUT: return VLP::NetIndex::D_INOUT;
+    default:                 return VLP::NetIndex::D_UNKNOWN;
+    }
+}
+
+static bool is_driver(const VLP::NetIndex::Pin &p)
+{
+    if (p.inst == VLP::NetIndex::npos) {
+        return p.dir == VLP::NetIndex::D_IN  || p.dir == VLP::NetIndex::D_INOUT;
+    }
+    return p.dir == VLP::NetIndex::D_OUT || p.dir == VLP::NetIndex::D_INOUT;
+}
+
+// Gate primitives: the number of leading output terminals, 0 if model is
+// not a primitive. buf and not drive all their terminals but the last.
+static unsigned primitive_outputs(const char *model,const size_t nports)
+{
+    static const char *const single[] = {"and","nand","or","nor","xor","xnor"};
+
+    for (size_t x=0; x<sizeof(single)/sizeof(single[0]); ++x) {
+        if (strcmp(model,single[x]) == 0) {
+            return 1;
+        }
+    }
+    if (strcmp(model,"buf") == 0 || strcmp(model,"not") == 0) {
+        return nports > 1 ? nports - 1 : 1;
+    }
+    return 0;
+}
+
+// Port directions of a user module, by port name and by position
+struct module_ports {
+    NameIndex                   names;
+    vector<VLP::NetIndex::T_Dir> dirs;       // Indexed by wire
+    vector<VLP::NetIndex::T_Dir> positional; // Indexed by port position
+
+    module_ports(const VLP::Module *m) {
+        const VLP::WireList &wl = m->get_wire_list();
+        const VLP::NameList &pl = m->get_port_names();
+
+        names.reserve(wl.size());
+        for (size_t x=0; x<wl.size(); ++x) {
+            names.insert(wl[x]->get_name(),static_cast<unsigned>(x));
+            dirs.push_back(wire_dir(wl[x]));
+        }
+        for (size_t x=0; x<pl.size(); ++x) {
+            positional.push_back(dir(pl[x]));
+        }
+    }
+    VLP::NetIndex::T_Dir dir(const char *name) const {
+        const unsigned w = names.find(name);
+        return w == NameIndex::npos ? VLP::NetIndex::D_UNKNOWN : dirs[w];
+    }
+};
+
+VLP::NetIndex::NetIndex(const Module *m,PinDirection dirfn,void *user):
+    _module(m),_names(new NameIndex())
+{
+    const WireList &wl = m->get_wire_list();
+    const NameList &pl = m->get_port_names();
+    const InstList &il = m->get_instance_list();
+    vector<connection>     conns;
+    NameIndex              models;   // Model name -> index in modports
+    vector<module_ports*>  modports; // 0 for library cells and primitives
+
+    _names->reserve(wl.size());
+    for (WireList::const_iterator x=wl.begin(); x!=wl.end(); ++x) {
+        add_net((*x)->get_name(),*x);
+    }
+
+    for (size_t x=0; x<pl.size(); ++x) {
+        const unsigned net = add_net(pl[x],0);
+        const Wire    *w   = _net_wires[net];
+        connection     c   = {net,{npos,static_cast<unsigned>(x),w ? wire_dir(w) : D_UNKNOWN}};
+
+        conns.push_back(c);
+    }
+
+    // One pass over the instances fills instance -> nets and collects the
+    // connections that are then bucketed by net
+    _insts.assign(il.begin(),il.end());
+    _inst_offset.reserve(il.size() + 1);
+    _inst_offset.push_back(0);
+    for (size_t i=0; i<il.size(); ++i) {
+        const Inst              *inst  = il[i];
+        const InstInterfaceList &ports = inst->get_ports();
+        const char              *model = inst->get_instance_module_name();
+        const unsigned           mx    = models.insert(model,static_cast<unsigned>(modports.size()));
+
+        if (mx == modports.size()) {
+            const Module *im = inst->get_instance_module();
+
+            modports.push_back(im ? new module_ports(im) : 0);
+        }
+        const module_ports      *mp    = modports[mx];
+        const unsigned           nprim = mp ? 0 : primitive_outputs(model,ports.size());
+        for (size_t p=0; p<ports.size(); ++p) {
+            const InstInterface *ii  = ports[p];
+            const char          *fml = ii->get_formal();
+            T_Dir                dir = D_UNKNOWN;
+
+            if (mp) {
+                dir = fml ? mp->dir(fml) : (p < mp->positional.size() ? mp->positional[p] : D_UNKNOWN);
+            } else if (nprim && !fml) {
+                dir = p < nprim ? D_OUT : D_IN;
+            } else if (dirfn) {
+                dir = dirfn(model,fml,static_cast<unsigned>(p),user);
+            }
+
+            const Expr *single = ii->get_actual_expr();
+            const ExprList *conc = ii->get_actual_conc();
+            const size_t    n    = conc ? conc->size() : (single ? 1 : 0);
+
+            for (size_t e=0; e<n; ++e) {
+                const Expr *expr = conc ? (*conc)[e] : single;
+
+                if (expr->get_type() == Expr::T_CONSTANT) {
+                    continue;
+                }
+                const unsigned net = add_net(expr->get_name(),0);
+                connection     c   = {net,{static_cast<unsigned>(i),static_cast<unsigned>(p),dir}};
+
+                _inst_nets.push_back(net);
+                conns.push_back(c);
+            }
+        }
+        _inst_offset.push_back(static_cast<unsigned>(_inst_nets.size()));
+    }
+    for (vector<module_ports*>::const_iterator x=modports.begin(); x!=modports.end(); ++x) {
+        delete *x;
+    }
+
+    // Counting sort by net, drivers first
+    const size_t nnets = _net_names.size();
+
+    _net_offset.assign(nnets + 1,0);
+    _net_drivers.assign(nnets,0);
+    for (vector<connection>::const_iterator c=conns.begin(); c!=conns.end(); ++c) {
+        ++_net_offset[c->net + 1];
+        _net_drivers[c->net] += is_driver(c->pin);
+    }
+    for (size_t n=0; n<nnets; ++n) {
+        _net_offset[n + 1] += _net_offset[n];
+    }
+
+    vector<unsigned> dpos(_net_offset.begin(),_net_offset.end() - 1);
+    vector<unsigned> lpos(nnets);
+
+    for (size_t n=0; n<nnets; ++n) {
+        lpos[n] = _net_offset[n] + _net_drivers[n];
+    }
+    _pins.resize(conns.size());
+    for (vector<connection>::const_iterator c=conns.begin(); c!=conns.end(); ++c) {
+        _pins[is_driver(c->pin) ? dpos[c->net]++ : lpos[c->net]++] = c->pin;
+    }
+}
+
+VLP::NetIndex::~NetIndex()
+{
+    delete _names;
+}
+
+// Returns the net of that name, creating an implicit one if needed
+unsigned VLP::NetIndex::add_net(const char *name,const Wire *w)
+{
+    const unsigned net = _names->insert(name,static_cast<unsigned>(_net_names.size()));
+
+    if (net < _net_names.size()) {
+        return net;
+    }
+    _net_names.push_back(name);
+    _net_wires.push_back(w);
+    return net;
+}
+
+unsigned VLP::NetIndex::find_net(const char *name) const
+{
+    return _names->find(name);
+}
@@ -2,37 +2,215 @@
 // Author: David Berthelot
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 #include <algorithm>
 #include <set>
-#include <map>
 #include "vlogobjects.hxx"
+#include "vlognets.hxx"
+#include "vlogbits.hxx"
+#include "vlogparser.hxx"
 #include "LexemeTable.hxx"
+#include "Arena.hxx"
+#include "ThreadPool.hxx"
+#include "MappedFile.hxx"
+#include "NameIndex.hxx"
 
 // int isatty(int x) {
 //     return 1;
 // }
 
-int          vlognetlistparse();
-extern FILE *vlognetlistin;
-extern int   vlognetlistdebug;
-int          VLP_line;
-LexemeTable *VLP_LEXEMES = 0;
-VLP::Design *topdesign   = 0;
+static VLP::Design *topdesign = 0;  // Design extended by incremental parses
 
-pair<bool,VLP::Design*> VLP::parse_vlog_file(const char *filename,const bool incremental)
+void VLP::Fingerprint::add(const char *text,const size_t len)
 {
-    topdesign        = (incremental && topdesign) ? topdesign : new Design();
-    vlognetlistin    = filename ? fopen(filename,"r") : stdin;
-    VLP_LEXEMES      = VLP_LEXEMES  ? VLP_LEXEMES : new LexemeTable();
-    vlognetlistdebug = 0;
-    VLP_line         = 1;
+    size_t   x = 0;
+    uint64_t w;
+
+    // Completes the word left over by the previous piece
+    for (; x < len && _len % 8; ++x, ++_len) {
+        _tail[_len % 8] = text[x];
+        if (_len % 8 == 7) {
+            memcpy(&w,_tail,8);
+            _hash  = (_hash ^ w) * 0xFF51AFD7ED558CCDULL;
+            _hash ^= _hash >> 32;
+        }
+    }
+    for (; x + 8 <= len; x += 8, _len += 8) {
+        memcpy(&w,text + x,8);
+        _hash  = (_hash ^ w) * 0xFF51AFD7ED558CCDULL;
+        _hash ^= _hash >> 32;
+    }
+    memcpy(_tail,text + x,len - x);
+    _len += len - x;
+}
+
+uint64_t VLP::Fingerprint::get() const
+{
+    uint64_t w = 0;
+    uint64_t h;
+
+    memcpy(&w,_tail,_len % 8);
+    h  = (_hash ^ w ^ _len) * 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 29;
+    return h | 1;
+}
+
+// Parses one file, the parsed modules are left in ctx->modules. A file
+// whose fingerprint is unchanged is not parsed. A file that isn't mapped is
+// scanned as it is read through stdio, and fingerprinted on the way when
+// building a design: the parse can't be skipped, the caller compares the
+// fingerprints.
+static bool parse_one(VLP::ParseContext *ctx,const bool use_mmap,const uint64_t unchanged=0)
+{
+    MappedFile m;
+
+    if (use_mmap && ctx->filename && m.open(ctx->filename,2)) {
+        VLP::Fingerprint text;
+
+        text.add(m.data(),m.size());
+        ctx->fingerprint = text.get();
+        return ctx->fingerprint == unchanged || VLP::parse_vlog_buffer(ctx,m.data(),m.size());
+    }
+    FILE *f = ctx->filename ? fopen(ctx->filename,"r") : stdin;
+
+    if (!f) {
+        printf("VLP-003: Cannot open %s\n",ctx->filename);
+        return false;
+    }
+    VLP::Fingerprint text;
+
+    ctx->text = (f != stdin && !ctx->handler) ? &text : 0;
+
+    bool isok = VLP::parse_vlog_stream(ctx,f);
+
+    if (ferror(f)) {
+        printf("VLP-003: Cannot read %s\n",ctx->filename ? ctx->filename : "stdin");
+        isok = false;
+    }
+    if (ctx->text) {
+        ctx->fingerprint = text.get();
+        ctx->text        = 0;
+    }
+    if (f != stdin) {
+        fclose(f);
+    }
+    return isok;
+}
+
+pair<bool,VLP::Design*> VLP::parse_vlog_file(const char *filename,const bool incremental,const bool use_mmap)
+{
+    topdesign = (incremental && topdesign) ? topdesign : new Design();
+
+    const bool isok = topdesign->reload(filename,use_mmap);
 
-    const bool isok = !vlognetlistparse();
-    
     return make_pair(isok,topdesign);
 }
 
+pair<bool,VLP::Design*> VLP::parse_vlog_files(const vector<const char*> &filenames,const unsigned nthreads,const bool use_mmap)
+{
+    Design                *design = new Design();
+    vector<ParseContext*>  ctxs;
+    vector<char>           status(filenames.size(),0);
+    ThreadPool             pool(nthreads);
+
+    for (size_t x=0; x<filenames.size(); ++x) {
+        ctxs.push_back(new ParseContext(filenames[x],design->get_lexemes()));
+    }
+    pool.run(filenames.size(),[&](size_t x) {status[x] = parse_one(ctxs[x],use_mmap);});
+
+    // Merged in file order so that duplicate modules resolve as in a sequential parse
+    bool isok = true;
+    for (size_t x=0; x<filenames.size(); ++x) {
+        design->add_source(filenames[x],ctxs[x]->fingerprint,&ctxs[x]->modules,&ctxs[x]->arena);
+        isok = isok && status[x];
+        delete ctxs[x];
+    }
+    topdesign = design;
+    return make_pair(isok,design);
+}
+
+bool VLP::stream_vlog_file(const char *filename,StreamHandler *handler,const bool use_mmap)
+{
+    ParseContext ctx(filename,handler);
+
+    return parse_one(&ctx,use_mmap);
+}
+
+
+//-----------------------------------------------------------------------------
+// Class ParseContext
+//-----------------------------------------------------------------------------
+
+// When streaming, the lexemes are swapped for a new table once it holds that many
+static const size_t stream_lexemes = 64 * 1024;
+
+VLP::ParseContext::ParseContext(const char *f,StreamHandler *h):
+    filename(f),lexemes(new LexemeTable()),arena(64*1024),line(1),handler(h),previous(new LexemeTable()),fingerprint(0),text(0)
+{
+}
+
+VLP::ParseContext::~ParseContext()
+{
+    if (handler) {
+        delete lexemes;
+        delete previous;
+    }
+}
+
+VLP::Module *VLP::ParseContext::begin_module(const char *name,NameList *ports,ObjectList *decls)
+{
+    if (!handler) {
+        Module *m = new Module(name,ports);
+
+        m->add_objects(decls);
+        return m;
+    }
+    module = name;
+    handler->on_module_begin(name,*ports);
+    delete ports;
+    stream(decls);
+    delete decls;
+    return 0;
+}
+
+VLP::Module *VLP::ParseContext::end_module(Module *m,ObjectList *body)
+{
+    if (!handler) {
+        m->add_objects(body);
+        return m;
+    }
+    stream(body);
+    delete body;
+    handler->on_module_end(module.c_str());
+    return 0;
+}
+
+// The objects are dead once streamed, so the arena is rewound. The lexemes
+// are kept one swap longer since the parser may hold a lookahead token.
+void VLP::ParseContext::stream(ObjectList *l)
+{
+    if (!handler) {
+        return;
+    }
+    for (ObjectList::const_iterator x=l->begin(); x!=l->end(); ++x) {
+        switch ((*x)->get_type()) {
+        case Object::O_WIRE:   handler->on_wire(static_cast<const Wire*>(*x));       break;
+        case Object::O_ASSIGN: handler->on_assign(static_cast<const Assign*>(*x));   break;
+        case Object::O_INST:   handler->on_instance(static_cast<const Inst*>(*x));   break;
+        default: break;
+        }
+        (*x)->~Object();
+    }
+    l->clear();
+    arena.rewind();
+    if (lexemes->size() > stream_lexemes) {
+        delete previous;
+        previous = lexemes;
+        lexemes  = new LexemeTable();
+    }
+}
+
 
 //-----------------------------------------------------------------------------
 // Class Object
@@ -62,30 +240,27 @@ bool VLP::Object::set_parent(Object *parent)
 //-----------------------------------------------------------------------------
 
 VLP::Expr::Expr(const char *name,const T_Type t):
-    Object(name,O_EXPR),_t(t),_index(-1)
+    Object(name,O_EXPR),_t(t),_range(-1,-1)
 {
 }
 
 VLP::Expr::Expr(const char *name,const int index):
-    Object(name,O_EXPR),_t(T_INDEX),_index(index)
+    Object(name,O_EXPR),_t(T_INDEX),_range(index,-1)
 {
 }
 
-VLP::Expr::Expr(const char *name,const Range *range):
+VLP::Expr::Expr(const char *name,const Range &range):
     Object(name,O_EXPR),_t(T_RANGE),_range(range)
 {
 }
 
 VLP::Expr::~Expr()
 {
-    if (get_type() == T_RANGE) {
-        delete _range;
-    }
 }
 
 VLP::Expr::T_Type VLP::Expr::get_type()  const {return _t;}
-int               VLP::Expr::get_index() const {return get_type() == T_INDEX ? _index : -1;}
-const VLP::Range *VLP::Expr::get_range() const {return get_type() == T_RANGE ? _range : 0;}
+int               VLP::Expr::get_index() const {return get_type() == T_INDEX ? _range.first : -1;}
+const VLP::Range *VLP::Expr::get_range() const {return get_type() == T_RANGE ? &_range : 0;}
 
 bool VLP::Expr::print() const 
 {
@@ -114,16 +289,18 @@ bool VLP::Expr::print() const
 //-----------------------------------------------------------------------------
 
 VLP::Inst::Inst(const char *model,const char *name,InstInterfaceList *ports):
-    Object(name,O_INST),_model(model),_ports(*ports)
+    Object(name,O_INST),_model(model)
 {
+    _ports.swap(*ports);
     delete ports;
 }
 
+// The interfaces live in the design arena, only the lists they own are freed
 VLP::Inst::~Inst() 
 {
     InstInterfaceList::const_iterator eit = _ports.begin();
     while (eit != _ports.end()) {
-        delete (*eit);
+        (*eit)->~InstInterface();
         eit++;
     }
 }
@@ -182,12 +359,7 @@ VLP::InstInterface::InstInterface(const char *name,const ExprList *lexpr):
 VLP::InstInterface::~InstInterface()
 {
     if (_is_conc) {
-        for (ExprList::const_iterator x=_lexpr->begin(); x!=_lexpr->end(); ++x) {
-            delete *x;
-        }
         delete _lexpr;
-    } else if (_expr) {
-        delete _expr;
     }
 }
 
@@ -229,14 +401,18 @@ bool VLP::InstInterface::print() const
 // Class Wire
 //-----------------------------------------------------------------------------
 
-VLP::Wire::Wire(const char *name,T_Wire t,Range *r):
-    Object(name,O_WIRE),_twire(t),_range(r)
+VLP::Wire::Wire(const char *name,T_Wire t):
+    Object(name,O_WIRE),_twire(t),_has_range(false),_range(-1,-1)
+{
+}
+
+VLP::Wire::Wire(const char *name,T_Wire t,const Range &r):
+    Object(name,O_WIRE),_twire(t),_has_range(true),_range(r)
 {
 }
 
 VLP::Wire::~Wire()
 {
-    delete _range;
 }
 
 const VLP::Module *VLP::Wire::get_parent_module() const
@@ -251,7 +427,7 @@ VLP::Wire::T_Wire  VLP::Wire::get_type()  const
 
 const VLP::Range  *VLP::Wire::get_range() const
 {
-    return _range;
+    return _has_range ? &_range : 0;
 }
 
 bool VLP::Wire::print() const 
@@ -279,8 +455,6 @@ VLP::Assign::Assign(const Expr *lhs,const Expr *rhs):
 
 VLP::Assign::~Assign()
 {
-    if (_lhs) delete _lhs;
-    if (_rhs) delete _rhs;
 }
 
 const VLP::Expr   *VLP::Assign::get_lhs() const {return _lhs;}
@@ -307,29 +481,31 @@ bool VLP::Assign::print() const
 // Class Module
 //-----------------------------------------------------------------------------
 
+// Wires and instances by name
+struct VLP::Module::names {
+    NameIndex wires;
+    NameIndex insts;
+};
+
 VLP::Module::Module(const char *name,NameList *nl):
-    Object(name,O_MODULE),_namelist(*nl)
+    Object(name,O_MODULE),_nets(0),_bits(0),_names(0)
 {
+    _namelist.swap(*nl);
     delete nl;
 }
 
+// Wires, assignments and instances live in the design arena, only the
+// lists owned by instances are freed
 VLP::Module::~Module() 
 {
-    WireList::const_iterator wit = _wirelist.begin();
-    while (wit != _wirelist.end()) {
-        delete (*wit);
-        wit++;
-    }
-    AssignList::const_iterator ait = _assignlist.begin();
-    while (ait != _assignlist.end()) {
-        delete (*ait);
-        ait++;
-    }
     InstList::const_iterator iit = _instlist.begin();
     while (iit != _instlist.end()) {
-        delete (*iit);
+        (*iit)->~Inst();
         iit++;
     }
+    delete _nets.load();
+    delete _bits.load();
+    delete _names.load();
 }
 
 bool VLP::Module::add_wire(Wire *w)
@@ -354,9 +530,24 @@ bool VLP::Module::add_inst(Inst *i)
 // Frees *ol
 bool VLP::Module::add_objects(ObjectList *ol)
 {
-    bool res = true;
-    ObjectList::const_iterator it = ol->begin();
-    
+    bool   res = true;
+    size_t nw  = 0, na = 0, ni = 0;
+    ObjectList::const_iterator it;
+
+    // Size the lists once, a module may hold millions of instances
+    for (it = ol->begin(); it != ol->end(); ++it) {
+        switch((*it)->get_type()) {
+        case O_WIRE:   ++nw; break;
+        case O_ASSIGN: ++na; break;
+        case O_INST:   ++ni; break;
+        default:             break;
+        }
+    }
+    _wirelist.reserve(_wirelist.size() + nw);
+    _assignlist.reserve(_assignlist.size() + na);
+    _instlist.reserve(_instlist.size() + ni);
+
+    it = ol->begin();
     while (res && (it != ol->end())) {
         switch((*it)->get_type()) {
         case O_WIRE:
@@ -383,6 +574,80 @@ const VLP::Design *VLP::Module::get_design() const
     return dynamic_cast<Design*>(this->get_parent());
 }
 
+// Returns a cache, built on first use. Threads racing on the first call
+// may each build one, only one is kept.
+template <class T,class B> static T *build_once(atomic<T*> &cache,const B &build)
+{
+    T *c = cache.load(memory_order_acquire);
+
+    if (!c) {
+        T *expected = 0;
+
+        c = build();
+        if (!cache.compare_exchange_strong(expected,c,memory_order_acq_rel)) {
+            delete c;
+            c = expected;
+        }
+    }
+    return c;
+}
+
+const VLP::NetIndex *VLP::Module::get_net_index() const
+{
+    return build_once(_nets,[this]() {return new NetIndex(this);});
+}
+
+const VLP::BitIndex *VLP::Module::get_bit_index() const
+{
+    return build_once(_bits,[this]() {return new BitIndex(this);});
+}
+
+void VLP::Module::drop_net_index()
+{
+    delete _nets.exchange(0);
+}
+
+const VLP::Module::names *VLP::Module::get_names() const
+{
+    return build_once(_names,[this]() {
+        names *n = new names();
+
+        n->wires.reserve(_wirelist.size());
+        for (size_t x=0; x<_wirelist.size(); ++x) {
+            n->wires.insert(_wirelist[x]->get_name(),static_cast<unsigned>(x));
+        }
+        n->insts.reserve(_instlist.size());
+        for (size_t x=0; x<_instlist.size(); ++x) {
+            n->insts.insert(_instlist[x]->get_name(),static_cast<unsigned>(x));
+        }
+        return n;
+    });
+}
+
+const VLP::Wire *VLP::Module::find_wire(const char *name) const
+{
+    return find_wire(name,strlen(name));
+}
+
+const VLP::Wire *VLP::Module::find_wire(const char *name,const size_t len) const
+{
+    const unsigned x = get_names()->wires.find(name,len);
+
+    return x == NameIndex::npos ? 0 : _wirelist[x];
+}
+
+const VLP::Inst *VLP::Module::find_instance(const char *name) const
+{
+    return find_instance(name,strlen(name));
+}
+
+const VLP::Inst *VLP::Module::find_instance(const char *name,const size_t len) const
+{
+    const unsigned x = get_names()->insts.find(name,len);
+
+    return x == NameIndex::npos ? 0 : _instlist[x];
+}
+
 bool VLP::Module::print() const 
 {
     bool isok = true;
@@ -423,33 +688,65 @@ bool VLP::Module::print() const
 // Class Design
 //-----------------------------------------------------------------------------
 
+// The objects of the modules of a file are held by the arena of the file,
+// so that they are released when the file is reloaded
+static const unsigned no_file = ~0u; // File of the modules of stdin and snapshots
+
+struct VLP::Design::source {
+    const char               *name;        // Lexeme
+    uint64_t                  fingerprint;
+    Arena                    *arena;
+};
+
 struct VLP::Design::data {
-    LexemeTable               t;
+    LexemeTable               t;    // Concurrent, files of one design may be lexed in parallel
+    Arena                     a;    // Owns every object below the modules of stdin and snapshots
     ModuleList                ml;
-    map<const char*,Module*>  mm;
+    NameIndex                 mm;   // Module name -> index in ml, lookups never insert
+    vector<unsigned>          mf;   // Index in ml -> index in files, or no_file
+    vector<source>            files;
+    NameIndex                 ff;   // File name -> index in files
+    ModuleList                dl;   // Modules rejected as duplicates, in parse order
+    vector<unsigned>          df;   // Index in dl -> index in files, or no_file
+
+    data():t(true),a(1024*1024) {}
+    ~data() {
+        for (size_t x=0; x<dl.size(); ++x) {
+            delete dl[x];
+        }
+        for (size_t x=0; x<files.size(); ++x) {
+            delete files[x].arena;
+        }
+    }
 };
 
 const char *root_design = "/work";
 
 VLP::Design::Design():Object(root_design,Object::O_DESIGN),_data(new data())
 {
-    topdesign   = this;
-    VLP_LEXEMES = &_data->t;
 }
 
 VLP::Design::~Design()
 {
-    for (map<const char*,Module*>::const_iterator x=_data->mm.begin(); x!=_data->mm.end(); ++x) {
-        delete x->second;
+    for (ModuleList::const_iterator x=_data->ml.begin(); x!=_data->ml.end(); ++x) {
+        delete *x;
     }
-    if (VLP_LEXEMES == &_data->t) {
-        VLP_LEXEMES = 0;
-        assert(topdesign == this);
-        topdesign   = 0;
+    if (topdesign == this) {
+        topdesign = 0;
     }
     delete _data;
 }
 
+LexemeTable *VLP::Design::get_lexemes() const
+{
+    return &_data->t;
+}
+
+Arena *VLP::Design::get_arena() const
+{
+    return &_data->a;
+}
+
 const VLP::ModuleList &VLP::Design::get_modules() const
 {
     return _data->ml;
@@ -457,27 +754,146 @@ const VLP::ModuleList &VLP::Design::get_modules() const
 
 const VLP::Module     *VLP::Design::get_module(const char *name) const
 {
-    const char *lname = _data->t.get(name);
-    map<const char*,Module*>::const_iterator f = _data->mm.find(lname);
+    return get_module(name,strlen(name));
+}
 
-    if (f == _data->mm.end()) {
-        return 0;
-    } else {
-        return f->second;
-    }
+const VLP::Module     *VLP::Design::get_module(const char *name,const size_t len) const
+{
+    const unsigned x = _data->mm.find(name,len);
+
+    return x == NameIndex::npos ? 0 : _data->ml[x];
 }
 
 bool VLP::Design::add_module(VLP::Module *m) 
 {
-    if (_data->mm.find(m->get_name()) == _data->mm.end()) {
-        _data->mm.insert(make_pair(m->get_name(),m));
+    const unsigned x = static_cast<unsigned>(_data->ml.size());
+
+    if (_data->mm.insert(m->get_name(),x) == x) {
         _data->ml.push_back(m);
+        _data->mf.push_back(no_file);
         return m->set_parent(this);
     } else {
         return false;
     }
 }
 
+// The modules of a previous parse of the file are deleted, with the index
+// of the module names since it can't forget a name. A module rejected as a
+// duplicate is kept, and takes the place of the module it duplicates when
+// the file of that module no longer defines it. The connectivity of a
+// module depends on the ports of the modules it instantiates: the indexes
+// of the modules instantiating a name that was removed, added or replaced
+// are dropped.
+void VLP::Design::add_source(const char *filename,const uint64_t fingerprint,ModuleList *modules,Arena *arena)
+{
+    const char    *name = filename ? _data->t.get(filename) : 0;
+    const unsigned s    = name ? _data->ff.insert(name,static_cast<unsigned>(_data->files.size())) : no_file;
+    vector<const char*> changed;
+
+    if (s == _data->files.size()) {
+        const source f = {name,fingerprint,new Arena()};
+
+        _data->files.push_back(f);
+    } else if (s != no_file) {
+        ModuleList       ml,dl;
+        vector<unsigned> mf,df;
+
+        _data->mm = NameIndex();
+        for (size_t x=0; x<_data->ml.size(); ++x) {
+            if (_data->mf[x] == s) {
+                changed.push_back(_data->ml[x]->get_name());
+                delete _data->ml[x];
+            } else {
+                _data->mm.insert(_data->ml[x]->get_name(),static_cast<unsigned>(ml.size()));
+                ml.push_back(_data->ml[x]);
+                mf.push_back(_data->mf[x]);
+            }
+        }
+        for (size_t x=0; x<_data->dl.size(); ++x) {
+            if (_data->df[x] == s) {
+                delete _data->dl[x];
+            } else {
+                dl.push_back(_data->dl[x]);
+                df.push_back(_data->df[x]);
+            }
+        }
+        _data->ml.swap(ml);
+        _data->mf.swap(mf);
+        _data->dl.swap(dl);
+        _data->df.swap(df);
+        _data->files[s].arena->release();
+        _data->files[s].fingerprint = fingerprint;
+    }
+    const size_t removed = changed.size();
+
+    for (ModuleList::const_iterator x=modules->begin(); x!=modules->end(); ++x) {
+        if (add_module(*x)) {
+            _data->mf.back() = s;
+            changed.push_back((*x)->get_name());
+        } else {
+            _data->dl.push_back(*x);
+            _data->df.push_back(s);
+        }
+    }
+    modules->clear();
+    (s == no_file ? _data->a : *_data->files[s].arena).adopt(*arena);
+
+    // Names are lexemes of the design, compared by address. The first
+    // duplicate of a removed module that the file doesn't define again
+    // takes its place.
+    for (size_t x=0; x<removed; ++x) {
+        if (_data->mm.find(changed[x]) != NameIndex::npos) {
+            continue;
+        }
+        for (size_t d=0; d<_data->dl.size(); ++d) {
+            if (_data->dl[d]->get_name() == changed[x]) {
+                add_module(_data->dl[d]);
+                _data->mf.back() = _data->df[d];
+                _data->dl.erase(_data->dl.begin() + d);
+                _data->df.erase(_data->df.begin() + d);
+                break;
+            }
+        }
+    }
+    sort(changed.begin(),changed.end());
+    for (size_t x=0; x<_data->ml.size(); ++x) {
+        const InstList &il = _data->ml[x]->get_instance_list();
+
+        for (size_t i=0; i<il.size(); ++i) {
+            if (binary_search(changed.begin(),changed.end(),il[i]->get_instance_module_name())) {
+                _data->ml[x]->drop_net_index();
+                break;
+            }
+        }
+    }
+}
+
+bool VLP::Design::reload(const char *filename,const bool use_mmap)
+{
+    const unsigned s = filename ? _data->ff.find(filename) : no_file;
+    ParseContext   ctx(filename,&_data->t);
+    const bool     isok = parse_one(&ctx,use_mmap,(s != no_file) ? _data->files[s].fingerprint : 0);
+
+    // An unchanged file was not parsed, or not kept when it was streamed.
+    // A file that fails keeps its modules
+    if (s != no_file && (!isok || (ctx.fingerprint && ctx.fingerprint == _data->files[s].fingerprint))) {
+        for (ModuleList::const_iterator x=ctx.modules.begin(); x!=ctx.modules.end(); ++x) {
+            delete *x;
+        }
+        return isok;
+    }
+    add_source(filename,ctx.fingerprint,&ctx.modules,&ctx.arena);
+    return isok;
+}
+
+const char *VLP::Design::get_filename(const Module *m) const
+{
+    const unsigned x = _data->mm.find(m->get_name());
+    const unsigned s = (x != NameIndex::npos && _data->ml[x] == m) ? _data->mf[x] : no_file;
+
+    return s == no_file ? 0 : _data->files[s].name;
+}
+
 bool VLP::Design::print() const 
 {
     bool                       isok = true;
@@ -0,0 +1,63 @@
+// Verilog netlist reader
+// Author: David Berthelot
+//
+// Per parse state shared by the reentrant lexer and parser (internal header)
+
+#ifndef VLOGNETLIST_PARSER
+#define VLOGNETLIST_PARSER
+
+#include <stdio.h>
+#include <string>
+#include "vlogobjects.hxx"
+#include "Arena.hxx"
+
+class LexemeTable;
+
+namespace VLP {
+    /// @internal Fingerprint of a text given in pieces of any size: words of 8 bytes are mixed in one at a
+    /// time, so that an unchanged file is recognized at memory speed
+    class Fingerprint {
+        public:
+            Fingerprint():_hash(0x9E3779B97F4A7C15ULL),_len(0) {}
+
+            void     add(const char *text,const size_t len);
+            uint64_t get() const; ///< Of the text added so far, never 0 which stands for no fingerprint
+
+        private:
+            uint64_t _hash;
+            size_t   _len;     ///< Added so far, the last _len % 8 bytes are still in _tail
+            char     _tail[8];
+    };
+
+    /// @internal State of one parse, lets several files be parsed at the same time
+    struct ParseContext {
+        const char    *filename; ///< Used in messages, 0 for stdin
+        LexemeTable   *lexemes;  ///< Interns identifiers, shared between parses of the same design
+        Arena          arena;    ///< Holds the parsed objects until the design takes them over
+        ModuleList     modules;  ///< Modules in the order they were parsed
+        int            line;
+        StreamHandler *handler;  ///< Receives the objects instead of modules when streaming, else 0
+        LexemeTable   *previous; ///< When streaming, the lexemes before the last swap: the lookahead token may point into them
+        string         module;   ///< When streaming, the name of the current module
+        uint64_t       fingerprint; ///< Of the text of the file, 0 when it was streamed to a handler or read from stdin
+        Fingerprint   *text;        ///< Takes the text as the scanner reads it from a file, else 0
+
+        ParseContext(const char *f,LexemeTable *t):filename(f),lexemes(t),arena(1024*1024),line(1),handler(0),previous(0),fingerprint(0),text(0) {}
+        ParseContext(const char *f,StreamHandler *h); ///< Owns its lexemes, which are dropped as objects are streamed
+        ~ParseContext();
+
+        /// Returns the new module, or 0 when streaming (the ports are streamed). Takes ports and decls.
+        Module *begin_module(const char *name,NameList *ports,ObjectList *decls);
+        /// Returns m with the objects of body, or 0 when streaming. Takes body.
+        Module *end_module(Module *m,ObjectList *body);
+        /// When streaming, hands the objects of l to the handler and empties l, else does nothing
+        void    stream(ObjectList *l);
+    };
+
+    /// @internal Parses f into ctx->modules, returns false on syntax errors
+    bool parse_vlog_stream(ParseContext *ctx,FILE *f);
+    /// @internal Same as parse_vlog_stream, scanning buf in place. buf[len] and buf[len+1] must be 0, the scanner writes to buf
+    bool parse_vlog_buffer(ParseContext *ctx,char *buf,const size_t len);
+};
+
+#endif
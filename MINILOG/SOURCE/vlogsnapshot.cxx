@@ -0,0 +1,332 @@
+// Verilog netlist reader
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "vlogobjects.hxx"
+#include "LexemeTable.hxx"
+#include "Arena.hxx"
+#include "SectionFile.hxx"
+
+// Snapshot sections, see SectionFile.hxx for the file layout. Loading
+// copies the string pool in one block, interns it without copying each
+// string, and constructs the objects in the design arena with exactly sized
+// lists. The expressions of an instance port or of an assignment are
+// consecutive records. Nothing is parsed.
+
+static const char     snapshot_magic[8] = {'V','L','P','S','N','A','P','\n'};
+static const uint32_t snapshot_version  = 2;
+static const uint32_t none              = SectionFile::none;
+
+enum {S_MODULES = SectionFile::FIRST_SECTION,
+      S_PORTNAMES,
+      S_WIRES,
+      S_EXPRS,
+      S_ASSIGNS,
+      S_INSTS,
+      S_INTERFACES,
+      S_COUNT};
+
+struct snap_module {
+    uint32_t name;
+    uint32_t first_port,nports;
+    uint32_t first_wire,nwires;
+    uint32_t first_assign,nassigns;
+    uint32_t first_inst,ninsts;
+};
+
+struct snap_wire {
+    uint32_t name;
+    uint32_t type;
+    int32_t  first,second;      // Range, first < 0 if there is none
+};
+
+struct snap_expr {
+    uint32_t name;
+    uint32_t type;
+    int32_t  first,second;      // Index in first or range
+};
+
+struct snap_assign {
+    uint32_t lhs,rhs;
+};
+
+struct snap_inst {
+    uint32_t model,name;
+    uint32_t first_interface,ninterfaces;
+};
+
+struct snap_interface {
+    uint32_t formal;            // none for position mapped ports
+    uint32_t is_conc;
+    uint32_t first_expr,nexprs;
+};
+
+static const size_t record_size[S_COUNT - SectionFile::FIRST_SECTION] = {sizeof(snap_module),sizeof(uint32_t),sizeof(snap_wire),
+                                                                         sizeof(snap_expr),sizeof(snap_assign),sizeof(snap_inst),
+                                                                         sizeof(snap_interface)};
+
+//-----------------------------------------------------------------------------
+// Save
+//-----------------------------------------------------------------------------
+
+struct snap_writer {
+    SectionWriter           file;
+    vector<snap_module>     modules;
+    vector<uint32_t>        portnames;
+    vector<snap_wire>       wires;
+    vector<snap_expr>       exprs;
+    vector<snap_assign>     assigns;
+    vector<snap_inst>       insts;
+    vector<snap_interface>  interfaces;
+
+    uint32_t string_id(const char *s) {return file.add_string(s);}
+    uint32_t expr(const VLP::Expr *e);
+};
+
+uint32_t snap_writer::expr(const VLP::Expr *e)
+{
+    if (!e) {
+        return none;
+    }
+    snap_expr r = {string_id(e->get_name()),static_cast<uint32_t>(e->get_type()),-1,-1};
+
+    if (e->get_type() == VLP::Expr::T_INDEX) {
+        r.first = e->get_index();
+    } else if (e->get_type() == VLP::Expr::T_RANGE) {
+        r.first  = e->get_range()->first;
+        r.second = e->get_range()->second;
+    }
+    exprs.push_back(r);
+    return static_cast<uint32_t>(exprs.size() - 1);
+}
+
+bool VLP::Design::save_snapshot(const char *path) const
+{
+    snap_writer w;
+
+    for (ModuleList::const_iterator m=get_modules().begin(); m!=get_modules().end(); ++m) {
+        const NameList   &nl = (*m)->get_port_names();
+        const WireList   &wl = (*m)->get_wire_list();
+        const AssignList &al = (*m)->get_assign_list();
+        const InstList   &il = (*m)->get_instance_list();
+        snap_module       r;
+
+        r.name         = w.string_id((*m)->get_name());
+        r.first_port   = static_cast<uint32_t>(w.portnames.size());
+        r.nports       = static_cast<uint32_t>(nl.size());
+        r.first_wire   = static_cast<uint32_t>(w.wires.size());
+        r.nwires       = static_cast<uint32_t>(wl.size());
+        r.first_assign = static_cast<uint32_t>(w.assigns.size());
+        r.nassigns     = static_cast<uint32_t>(al.size());
+        r.first_inst   = static_cast<uint32_t>(w.insts.size());
+        r.ninsts       = static_cast<uint32_t>(il.size());
+        w.modules.push_back(r);
+
+        for (NameList::const_iterator x=nl.begin(); x!=nl.end(); ++x) {
+            w.portnames.push_back(w.string_id(*x));
+        }
+        for (WireList::const_iterator x=wl.begin(); x!=wl.end(); ++x) {
+            const Range *rg = (*x)->get_range();
+            snap_wire    sw = {w.string_id((*x)->get_name()),static_cast<uint32_t>((*x)->get_type()),rg ? rg->first : -1,rg ? rg->second : -1};
+
+            w.wires.push_back(sw);
+        }
+        for (AssignList::const_iterator x=al.begin(); x!=al.end(); ++x) {
+            snap_assign sa;
+
+            sa.lhs = w.expr((*x)->get_lhs());
+            sa.rhs = w.expr((*x)->get_rhs());
+            w.assigns.push_back(sa);
+        }
+        for (InstList::const_iterator x=il.begin(); x!=il.end(); ++x) {
+            const InstInterfaceList &pl = (*x)->get_ports();
+            snap_inst                si = {w.string_id((*x)->get_instance_module_name()),w.string_id((*x)->get_name()),
+                                           static_cast<uint32_t>(w.interfaces.size()),static_cast<uint32_t>(pl.size())};
+
+            w.insts.push_back(si);
+            for (InstInterfaceList::const_iterator p=pl.begin(); p!=pl.end(); ++p) {
+                snap_interface sf = {w.string_id((*p)->get_formal()),(*p)->is_actual_conc(),static_cast<uint32_t>(w.exprs.size()),0};
+
+                if ((*p)->is_actual_conc()) {
+                    const ExprList *l = (*p)->get_actual_conc();
+
+                    for (ExprList::const_iterator e=l->begin(); e!=l->end(); ++e) {
+                        w.expr(*e);
+                    }
+                } else {
+                    w.expr((*p)->get_actual_expr());
+                }
+                sf.nexprs = static_cast<uint32_t>(w.exprs.size()) - sf.first_expr;
+                w.interfaces.push_back(sf);
+            }
+        }
+    }
+    if (w.file.get_string_bytes() >= none || w.exprs.size() >= none || w.interfaces.size() >= none) {
+        printf("VLP-007: Design too large for a snapshot\n");
+        return false;
+    }
+    bool isok = w.file.open(path,snapshot_magic,snapshot_version,S_COUNT);
+
+    isok = isok && w.file.write(w.modules);
+    isok = isok && w.file.write(w.portnames);
+    isok = isok && w.file.write(w.wires);
+    isok = isok && w.file.write(w.exprs);
+    isok = isok && w.file.write(w.assigns);
+    isok = isok && w.file.write(w.insts);
+    isok = isok && w.file.write(w.interfaces);
+    isok = w.file.close() && isok;
+    if (!isok) {
+        printf("VLP-007: Cannot write %s\n",path);
+    }
+    return isok;
+}
+
+//-----------------------------------------------------------------------------
+// Load
+//-----------------------------------------------------------------------------
+
+struct snap_reader {
+    SectionReader        file;
+    vector<const char*>  strings;   // Interned
+    Arena               *arena;
+
+    // Checks an index read from the file, a bad one leaves a null string or object
+    bool        valid(const uint32_t x,const int s,const uint32_t n=1) {return file.valid(x,s,n);}
+    const char *string(const uint32_t x) {return x != none && valid(x,SectionFile::OFFSETS) ? strings[x] : 0;}
+    VLP::Expr  *expr(const uint32_t x);
+};
+
+VLP::Expr *snap_reader::expr(const uint32_t x)
+{
+    if (x == none || !valid(x,S_EXPRS)) {
+        return 0;
+    }
+    const snap_expr &r    = file.section<snap_expr>(S_EXPRS)[x];
+    const char      *name = string(r.name);
+
+    if (r.type > VLP::Expr::T_CONSTANT) {
+        file.fail();
+        return 0;
+    }
+    switch (r.type) {
+    case VLP::Expr::T_INDEX: return new (*arena) VLP::Expr(name,static_cast<int>(r.first));
+    case VLP::Expr::T_RANGE: return new (*arena) VLP::Expr(name,VLP::Range(r.first,r.second));
+    default:                 return new (*arena) VLP::Expr(name,static_cast<VLP::Expr::T_Type>(r.type));
+    }
+}
+
+VLP::Design *VLP::Design::load_snapshot(const char *path)
+{
+    snap_reader r;
+
+    switch (r.file.open(path,snapshot_magic,snapshot_version,S_COUNT,record_size)) {
+    case SectionReader::R_OK:
+        break;
+    case SectionReader::R_MISSING:
+        printf("VLP-008: Cannot read %s\n",path);
+        return 0;
+    default:
+        printf("VLP-008: %s is not a snapshot of version %u\n",path,snapshot_version);
+        return 0;
+    }
+
+    Design      *d    = new Design();
+    LexemeTable *lex  = d->get_lexemes();
+    const size_t size = r.file.get_string_pool_size();
+    char        *pool;
+
+    r.arena = d->get_arena();
+    pool    = static_cast<char*>(r.arena->allocate(size,1));
+    memcpy(pool,r.file.get_string_pool(),size);
+    r.strings.resize(r.file.get_string_count());
+    for (size_t x=0; x<r.strings.size(); ++x) {
+        const char *s = pool + (r.file.string(static_cast<uint32_t>(x)) - r.file.get_string_pool());
+
+        r.strings[x] = lex->adopt(s,strlen(s));
+    }
+
+    const snap_module    *mods  = r.file.section<snap_module>(S_MODULES);
+    const uint32_t       *ports = r.file.section<uint32_t>(S_PORTNAMES);
+    const snap_wire      *wires = r.file.section<snap_wire>(S_WIRES);
+    const snap_assign    *asgns = r.file.section<snap_assign>(S_ASSIGNS);
+    const snap_inst      *insts = r.file.section<snap_inst>(S_INSTS);
+    const snap_interface *intfs = r.file.section<snap_interface>(S_INTERFACES);
+
+    for (size_t x=0; r.file.is_ok() && x<r.file.count(S_MODULES); ++x) {
+        const snap_module &sm = mods[x];
+
+        if (!r.valid(sm.first_port,S_PORTNAMES,sm.nports) || !r.valid(sm.first_wire,S_WIRES,sm.nwires) ||
+            !r.valid(sm.first_assign,S_ASSIGNS,sm.nassigns) || !r.valid(sm.first_inst,S_INSTS,sm.ninsts)) {
+            break;
+        }
+        NameList   *nl = new NameList();
+        ObjectList *ol = new ObjectList();
+
+        nl->reserve(sm.nports);
+        for (uint32_t p=0; p<sm.nports; ++p) {
+            nl->push_back(r.string(ports[sm.first_port + p]));
+        }
+        Module *mod = new Module(r.string(sm.name),nl);
+
+        ol->reserve(sm.nwires + sm.nassigns + sm.ninsts);
+        for (uint32_t w=0; w<sm.nwires; ++w) {
+            const snap_wire &sw = wires[sm.first_wire + w];
+            const char      *n  = r.string(sw.name);
+
+            if (!n || sw.type > Wire::W_TRI1) {
+                r.file.fail();
+            }
+
+            if (sw.first >= 0) {
+                ol->push_back(new (*r.arena) Wire(n,static_cast<Wire::T_Wire>(sw.type),Range(sw.first,sw.second)));
+            } else {
+                ol->push_back(new (*r.arena) Wire(n,static_cast<Wire::T_Wire>(sw.type)));
+            }
+        }
+        for (uint32_t a=0; a<sm.nassigns; ++a) {
+            const snap_assign &sa = asgns[sm.first_assign + a];
+
+            ol->push_back(new (*r.arena) Assign(r.expr(sa.lhs),r.expr(sa.rhs)));
+        }
+        for (uint32_t i=0; i<sm.ninsts && r.file.is_ok(); ++i) {
+            const snap_inst   &si = insts[sm.first_inst + i];
+            InstInterfaceList *pl = new InstInterfaceList();
+
+            if (r.valid(si.first_interface,S_INTERFACES,si.ninterfaces)) {
+                pl->reserve(si.ninterfaces);
+                for (uint32_t p=0; p<si.ninterfaces; ++p) {
+                    const snap_interface &sf = intfs[si.first_interface + p];
+                    const char           *fm = r.string(sf.formal);
+
+                    if (!r.valid(sf.first_expr,S_EXPRS,sf.nexprs)) {
+                        break;
+                    }
+                    if (sf.is_conc) {
+                        ExprList *l = new ExprList();
+
+                        l->reserve(sf.nexprs);
+                        for (uint32_t e=0; e<sf.nexprs; ++e) {
+                            l->push_back(r.expr(sf.first_expr + e));
+                        }
+                        pl->push_back(new (*r.arena) InstInterface(fm,l));
+                    } else {
+                        pl->push_back(new (*r.arena) InstInterface(fm,sf.nexprs ? r.expr(sf.first_expr) : static_cast<Expr*>(0)));
+                    }
+                }
+            }
+            ol->push_back(new (*r.arena) Inst(r.string(si.model),r.string(si.name),pl));
+        }
+        mod->add_objects(ol);
+        if (!r.file.is_ok() || !mod->get_name() || !d->add_module(mod)) {
+            delete mod;
+        }
+    }
+    if (!r.file.is_ok()) {
+        printf("VLP-008: %s is corrupted\n",path);
+        delete d;
+        return 0;
+    }
+    return d;
+}
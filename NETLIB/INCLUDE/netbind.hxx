@@ -0,0 +1,104 @@
+/// @file   netbind.hxx
+/// @brief  Binding of the instances of a verilog design to the cells of .LIB libraries
+/// @author David Berthelot
+
+#ifndef NETLIB_BIND
+#define NETLIB_BIND
+
+#include <vector>
+#include "libobjects.hxx"
+#include "vlogobjects.hxx"
+#include "vlognets.hxx"
+
+using namespace std;
+
+class NameIndex;
+
+namespace NETLIB {
+    /// Resolves once every instance of a design to its library cell, and every port of the instance to a pin of the cell
+    /** The instances of all the modules of the design are numbered densely: instance i of
+        design->get_modules()[m] is get_first_inst(m) + i, and the results are arrays indexed by that number.
+        Each model is bound once to the first library that has a cell of that name. Ports connected by name
+        are bound to the pin, bus or bundle group of that name, ports connected by position to the pins in
+        the order of the groups of the cell. Instances of modules of the design are not bound.
+        The design and the libraries must outlive the binding.
+        Example: @code
+NETLIB::Binding b(design,libraries);
+const unsigned  i = b.get_first_inst(0);
+for (unsigned p=0; b.get_cell(i) && p<b.get_port_count(i); ++p) {
+    const NETLIB::Binding::Pin *pin = b.get_pin(i,p);
+    ...
+} @endcode
+    */
+    class Binding {
+    public:
+        static const unsigned npos = ~0u; ///< Returned by lookups that fail
+
+        /// A pin of a cell: a pin, bus or bundle group
+        struct Pin {
+            const char             *name;        ///< As written in the library
+            const DLIB::Group      *group;       ///< The pin, bus or bundle group
+            VLP::NetIndex::T_Dir    dir;         ///< From the direction attribute, D_UNKNOWN for internal pins or when there is none
+            float                   capacitance; ///< From the capacitance attribute, 0 when there is none
+        };
+
+        /// The cell bound to a model
+        struct Cell {
+            const char             *model;   ///< As in Inst::get_instance_module_name()
+            const DLIB::Group      *group;   ///< The cell group
+            const DLIB::Group      *library; ///< The library holding the cell
+            vector<Pin>             pins;    ///< In the order of the groups of the cell
+        };
+
+        /// Binds the instances of design to the cells of libraries
+        /** @param design holds the instances, it must outlive the binding
+            @param libraries are top level groups of .LIB libraries, searched in order, they must outlive the binding
+            @param nthreads is the number of threads binding the modules and cells, 0 uses one thread per hardware thread
+        */
+        Binding(const VLP::Design *design,const vector<const DLIB::Group*> &libraries,const unsigned nthreads=0);
+        ~Binding();
+
+        size_t          get_inst_count()                    const {return _inst_cell.size();}   ///< Returns the number of instances of all the modules
+        unsigned        get_first_inst(const unsigned module) const {return _module_first[module];} ///< Returns the number of the first instance of design->get_modules()[module]
+        unsigned        get_first_inst(const VLP::Module *m) const; ///< Same for a module of the design, npos for another module
+        /// Returns the cell of an instance, 0 for instances of modules of the design and of unbound models
+        const Cell     *get_cell(const unsigned inst)       const {return _inst_cell[inst] == npos ? 0 : &_cells[_inst_cell[inst]];}
+        /// Returns the number of ports of an instance, as Inst::get_ports().size()
+        size_t          get_port_count(const unsigned inst) const {return _port_first[inst+1] - _port_first[inst];}
+        /// Returns the pin of a port of an instance (index in Inst::get_ports()), 0 when the cell has no such pin
+        const Pin      *get_pin(const unsigned inst,const unsigned port) const;
+
+        size_t          get_cell_count()                    const {return _cells.size();}       ///< Returns the number of cells bound
+        const Cell     &get_cell_at(const unsigned cell)    const {return _cells[cell];}        ///< Returns a bound cell, 0 <= cell < get_cell_count()
+        /// Returns the cell of a model, 0 when it is not bound
+        const Cell     *find_cell(const char *model)        const;
+        /// Returns the index of the pin of that name in cell->pins, npos when the cell has none
+        unsigned        find_pin(const Cell *cell,const char *name) const;
+
+        /// Returns the models that are neither modules of the design nor cells of the libraries, verilog primitives included
+        const VLP::NameList &get_unbound_models()           const {return _unbound;}
+        /// Returns the number of instances of the models of get_unbound_models()
+        size_t          get_unbound_count()                 const {return _unbound_insts;}
+
+        /// Resolves the pins of library cells for VLP::NetIndex, user must be the binding
+        /** Example: @code VLP::NetIndex nets(module,NETLIB::Binding::pin_direction,&binding); @endcode */
+        static VLP::NetIndex::T_Dir pin_direction(const char *model,const char *formal,const unsigned position,void *user);
+
+    private:
+        vector<Cell>            _cells;
+        vector<NameIndex*>      _cell_pins;    // Cell -> pin name -> index in pins
+        NameIndex              *_models;       // Model -> cell
+        vector<unsigned>        _module_first; // Module -> first instance, size modules + 1
+        vector<pair<const VLP::Module*,unsigned> > _module_index; // Sorted by module
+        vector<unsigned>        _inst_cell;    // Instance -> cell, npos when unbound
+        vector<size_t>          _port_first;   // CSR instance -> ports
+        vector<unsigned>        _port_pin;     // Port -> index in the pins of the cell, npos when unbound
+        VLP::NameList           _unbound;
+        size_t                  _unbound_insts;
+
+        Binding(const Binding&);
+        Binding &operator=(const Binding&);
+    };
+};
+
+#endif
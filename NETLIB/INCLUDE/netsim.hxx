@@ -0,0 +1,111 @@
+/// @file   netsim.hxx
+/// @brief  Bit-parallel logic simulation of a flat verilog design with .LIB cell functions
+/// @author David Berthelot
+
+#ifndef NETLIB_SIM
+#define NETLIB_SIM
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "libobjects.hxx"
+#include "vlogflat.hxx"
+#include "netbind.hxx"
+
+using namespace std;
+
+/// NETLIB is the namespace of the tools that join a verilog netlist (VLP) to its .LIB library (DLIB)
+namespace NETLIB {
+    /// Evaluates the combinational logic of a flat design on many input patterns at a time
+    /** Each leaf instance is bound to the function attributes of the output pins of its .LIB cell (see
+        DLIB::Attr::get_function()), verilog primitives (and, nand, or, nor, xor, xnor, buf, not) to their
+        own function. The cells and the pins of the ports are those of a Binding of the design.
+        The gates are sorted by level, so that a pass evaluates each of them once.
+        The nets that no gate drives are the sources of the simulation: the ports of the top module, the
+        outputs of sequential cells (their functions depend on internal states such as IQ), of cells
+        missing from the library, and of gates cut to break combinational loops. Their values are set by
+        set_source() or randomize(), the other nets are computed by run().
+        The value of a net is get_words() words of 64 bits, bit k of word w is its value in pattern 64*w+k.
+        Tristate enables are ignored, constant nets are 0 and 1, X and Z nets are 0.
+        Example: @code
+NETLIB::Binding   binding(design,libraries);
+NETLIB::Simulator sim(design->flatten(top),&binding);
+for (int x=0; x<1000; ++x) {
+    sim.randomize(x);
+    sim.run();
+}
+double rate = double(sim.get_toggles(net)) / sim.get_toggle_patterns(); @endcode
+    */
+    class Simulator {
+    public:
+        static const unsigned npos = ~0u; ///< Returned by get_driver() for source nets
+
+        /// Takes the cells of the instances of flat from binding and sorts them by level
+        /** @param flat is the design, it must outlive the simulator
+            @param binding is a binding of the design flat was flattened from, only used by the constructor
+            @param words is the number of 64 bit words per net: 1 for 64 patterns per pass, 4 for 256 (evaluated
+                   with AVX2 when the processor has it), any other value is rounded up to one of them
+        */
+        Simulator(const VLP::FlatDesign *flat,const Binding *binding,const unsigned words=4);
+        ~Simulator();
+
+        unsigned        get_words()        const {return _words;}          ///< Returns the number of 64 bit words per net
+        unsigned        get_patterns()     const {return _words * 64;}     ///< Returns the number of patterns per pass
+        size_t          get_gate_count()   const {return _gate_out.size();} ///< Returns the number of gates (one per output pin of a bound cell)
+        unsigned        get_level_count()  const {return _levels.size() - 1;} ///< Returns the number of levels of gates
+        size_t          get_unbound_count() const {return _unbound;}       ///< Returns the number of leaf instances of cells that are missing or have no function
+        size_t          get_loop_count()   const {return _loops;}          ///< Returns the number of gates cut to break combinational loops
+        /// Returns the nets that are set by set_source() or randomize() rather than computed
+        const vector<unsigned> &get_sources() const {return _sources;}
+        /// Returns the gate driving a net, npos for a source or constant net
+        unsigned        get_driver(const unsigned net) const {return _driver[net];}
+
+        /// Sets the values of a source net: get_words() words
+        void            set_source(const unsigned net,const uint64_t *values);
+        /// Sets random values on all source nets
+        /** @param seed selects the patterns, the same seed always gives the same patterns */
+        void            randomize(const uint64_t seed);
+        /// Evaluates the gates, level by level, and counts the toggles of the nets when enabled
+        void            run();
+        /// Returns the values of a net: get_words() words
+        const uint64_t *get_values(const unsigned net) const {return _values.data() + size_t(net) * _words;}
+
+        /// Starts counting the toggles of every net across the patterns of the following passes
+        /** The patterns of successive passes are taken as one sequence: pattern 0 of a pass follows the last
+            pattern of the previous pass. Counting again resets the counts.
+        */
+        void            count_toggles();
+        /// Returns the number of times a net changed value between consecutive patterns
+        uint64_t        get_toggles(const unsigned net) const {return _toggles.empty() ? 0 : _toggles[net];}
+        /// Returns the number of consecutive pattern pairs the toggles were counted on
+        uint64_t        get_toggle_patterns() const {return _toggle_patterns;}
+
+    private:
+        const VLP::FlatDesign           *_flat;
+        unsigned                         _words;
+        vector<uint64_t>                 _values;      // Net -> words
+        vector<unsigned>                 _driver;      // Net -> gate
+        vector<unsigned>                 _sources;
+        vector<const DLIB::Function*>    _gate_func;   // Gates sorted by level
+        vector<unsigned>                 _gate_out;
+        vector<unsigned>                 _gate_inputs; // CSR gate -> input nets
+        vector<unsigned>                 _gate_offset;
+        vector<unsigned>                 _levels;      // First gate of each level, size levels + 1
+        unsigned                         _max_inputs;
+        vector<DLIB::Function*>          _owned;       // Functions of the verilog primitives
+        size_t                           _unbound;
+        size_t                           _loops;
+        vector<uint64_t>                 _toggles;
+        vector<uint8_t>                  _last;        // Net -> value in the last pattern
+        uint64_t                         _toggle_patterns;
+
+        void                             levelize(const vector<const DLIB::Function*> &func,const vector<unsigned> &out,
+                                                  const vector<unsigned> &offset,const vector<unsigned> &inputs);
+        void                             add_toggles();
+
+        Simulator(const Simulator&);
+        Simulator &operator=(const Simulator&);
+    };
+};
+
+#endif
@@ -0,0 +1,72 @@
+/// @file   netstats.hxx
+/// @brief  Statistics of the hierarchy of a verilog design, rolled up the modules
+/// @author David Berthelot
+
+#ifndef NETLIB_STATS
+#define NETLIB_STATS
+
+#include <stdint.h>
+#include <vector>
+#include "vlogobjects.hxx"
+#include "netbind.hxx"
+
+using namespace std;
+
+namespace NETLIB {
+    /// Counts the instances, area and leakage of the hierarchy below every module of a design
+    /** The instances of each module are counted once, then the counts are rolled up from the modules that
+        instantiate no module to the top ones: a module shared by many instances is counted once whatever the
+        number of its instances, and the modules of a level of the hierarchy are rolled up in parallel.
+        The area and leakage are the sums of the area and cell_leakage_power attributes of the library cells
+        of the leaf instances, in the units of their libraries, when a binding is given.
+        The design must outlive the statistics.
+        Example: @code
+NETLIB::HierarchyStats s(design,&binding);
+const NETLIB::HierarchyStats::Stats *top = s.get_stats(design->get_module("top"));
+if (top) {
+    printf("%llu instances, area %g, depth %u\n",(unsigned long long) top->instances,top->area,top->depth);
+} @endcode
+    */
+    class HierarchyStats {
+    public:
+        /// The statistics of a module
+        struct Stats {
+            uint64_t                             instances;         ///< Instances of modules and of leaf models, at all levels
+            uint64_t                             leaf_instances;    ///< Instances of models that are not modules of the design
+            uint64_t                             unbound_instances; ///< Leaf instances without a library cell, missing from the area and leakage
+            double                               area;              ///< Sum of the area of the cells of the leaf instances
+            double                               leakage;           ///< Sum of the cell_leakage_power of the cells of the leaf instances
+            unsigned                             depth;             ///< Levels of modules from the module down, 1 when it instantiates no module
+            vector<pair<const char*,uint64_t> >  models;            ///< Leaf instances per model, sorted by model name
+        };
+
+        /// Counts the instances of each module of design and rolls the counts up the hierarchy
+        /** @param design holds the modules, it must outlive the statistics
+            @param binding gives the cells of the leaf instances, it must be a binding of design; without it the
+                   area and leakage are 0 and all the leaf instances are unbound
+            @param nthreads is the number of threads counting and rolling up the modules, 0 uses one thread per hardware thread
+        */
+        HierarchyStats(const VLP::Design *design,const Binding *binding=0,const unsigned nthreads=0);
+
+        /// Returns the statistics of the hierarchy below design->get_modules()[module], 0 if it is recursively instantiated
+        const Stats      *get_stats(const unsigned module) const {return _valid[module] ? &_stats[module] : 0;}
+        /// Same for a module of the design, 0 for another module
+        const Stats      *get_stats(const VLP::Module *m) const;
+        /// Returns the statistics of the instances of design->get_modules()[module] alone, depth is 1
+        const Stats      &get_local_stats(const unsigned module) const {return _local[module];}
+        /// Returns the modules that instantiate themselves, directly or through other modules, or instantiate such a module
+        const VLP::NameList &get_recursive_modules() const {return _recursive;}
+
+    private:
+        vector<Stats>                        _local;
+        vector<Stats>                        _stats;
+        vector<char>                         _valid;
+        vector<pair<const VLP::Module*,unsigned> > _module_index; // Sorted by module
+        VLP::NameList                        _recursive;
+
+        HierarchyStats(const HierarchyStats&);
+        HierarchyStats &operator=(const HierarchyStats&);
+    };
+};
+
+#endif
@@ -0,0 +1,250 @@
+// Netlist to library binding
+// Author: David Berthelot
+
+#include <string.h>
+#include <algorithm>
+#include "netbind.hxx"
+#include "NameIndex.hxx"
+#include "ThreadPool.hxx"
+
+// The instances are split in ranges of at most range_insts instances of
+// one module, the tasks of the pool. A first pass collects the models of
+// each range, which are then bound once each: to a module of the design
+// or to a library cell. A second pass binds the instances and their ports.
+// The models are lexemes of the design, the instances look them up by
+// address.
+
+static const unsigned range_insts = 64 * 1024;
+
+enum {M_MODULE,M_CELL,M_UNBOUND};
+
+struct inst_range {
+    unsigned module,begin,end;
+};
+
+static VLP::NetIndex::T_Dir pin_dir(const DLIB::Group *g)
+{
+    const DLIB::Attr *a = g->find_attr("direction");
+    const char       *d = a ? a->get_string() : 0;
+
+    if (!d) {
+        return VLP::NetIndex::D_UNKNOWN;
+    }
+    return !strcmp(d,"input") ? VLP::NetIndex::D_IN : (!strcmp(d,"output") ? VLP::NetIndex::D_OUT :
+           (!strcmp(d,"inout") ? VLP::NetIndex::D_INOUT : VLP::NetIndex::D_UNKNOWN));
+}
+
+// A group such as pin (A, B) declares several pins
+static void bind_pins(const DLIB::Group *cell,vector<NETLIB::Binding::Pin> *pins)
+{
+    for (DLIB::GroupList::const_iterator x=cell->get_subgroups()->begin(); x!=cell->get_subgroups()->end(); ++x) {
+        const DLIB::Group *g    = *x;
+        const char        *kind = g->get_name();
+
+        if ((strcmp(kind,"pin") && strcmp(kind,"bus") && strcmp(kind,"bundle")) || !g->get_args()) {
+            continue;
+        }
+        const DLIB::Attr *cap = g->find_attr("capacitance");
+
+        for (DLIB::ArgList::const_iterator a=g->get_args()->begin(); a!=g->get_args()->end(); ++a) {
+            const NETLIB::Binding::Pin p = {
+                (*a)->get_string(),g,pin_dir(g),(cap && cap->get_type() == DLIB::Arg::T_NUMBER) ? cap->get_number() : 0.0f
+            };
+
+            if (p.name) {
+                pins->push_back(p);
+            }
+        }
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+// Class Binding
+//-----------------------------------------------------------------------------
+const unsigned NETLIB::Binding::npos;
+
+NETLIB::Binding::Binding(const VLP::Design *design,const vector<const DLIB::Group*> &libraries,const unsigned nthreads):
+    _models(new NameIndex()),_unbound_insts(0)
+{
+    const VLP::ModuleList &ml = design->get_modules();
+    ThreadPool             pool(nthreads);
+    vector<inst_range>     ranges;
+
+    _module_first.reserve(ml.size() + 1);
+    _module_first.push_back(0);
+    for (unsigned m=0; m<ml.size(); ++m) {
+        const unsigned n = ml[m]->get_instance_list().size();
+
+        for (unsigned b=0; b<n; b+=range_insts) {
+            const inst_range r = {m,b,min(n,b + range_insts)};
+
+            ranges.push_back(r);
+        }
+        _module_first.push_back(_module_first.back() + n);
+        _module_index.push_back(make_pair(ml[m],m));
+    }
+    sort(_module_index.begin(),_module_index.end());
+
+    const size_t                 ninsts = _module_first.back();
+    vector<vector<const char*> > found(ranges.size());
+
+    _port_first.assign(ninsts + 1,0);
+    pool.run(ranges.size(),[&](size_t t) {
+        const inst_range     &r  = ranges[t];
+        const VLP::InstList  &il = ml[r.module]->get_instance_list();
+        vector<const char*>  &f  = found[t];
+
+        for (unsigned i=r.begin; i<r.end; ++i) {
+            f.push_back(il[i]->get_instance_module_name());
+            _port_first[_module_first[r.module] + i + 1] = il[i]->get_ports().size();
+        }
+        sort(f.begin(),f.end());
+        f.erase(unique(f.begin(),f.end()),f.end());
+    });
+
+    // Models by address, then by name: equal names may be distinct lexemes in a design loaded from a snapshot
+    vector<const char*> addrs;
+    vector<unsigned>    addr_model;
+    vector<const char*> models;
+    NameIndex           names;
+
+    for (size_t t=0; t<found.size(); ++t) {
+        addrs.insert(addrs.end(),found[t].begin(),found[t].end());
+        vector<const char*>().swap(found[t]);
+    }
+    sort(addrs.begin(),addrs.end());
+    addrs.erase(unique(addrs.begin(),addrs.end()),addrs.end());
+    for (size_t x=0; x<addrs.size(); ++x) {
+        addr_model.push_back(names.insert(addrs[x],static_cast<unsigned>(models.size())));
+        if (addr_model.back() == models.size()) {
+            models.push_back(addrs[x]);
+        }
+    }
+
+    // The cell lookups are indexed and may run on several threads
+    vector<char> kind(models.size(),M_UNBOUND);
+    vector<Cell> cells(models.size());
+
+    pool.run(models.size(),[&](size_t x) {
+        if (design->get_module(models[x])) {
+            kind[x] = M_MODULE;
+            return;
+        }
+        for (size_t l=0; l<libraries.size(); ++l) {
+            const DLIB::Group *cell = libraries[l] ? libraries[l]->find_group("cell",models[x]) : 0;
+
+            if (cell) {
+                kind[x]          = M_CELL;
+                cells[x].model   = models[x];
+                cells[x].group   = cell;
+                cells[x].library = libraries[l];
+                bind_pins(cell,&cells[x].pins);
+                return;
+            }
+        }
+    });
+    vector<unsigned> model_cell(models.size(),npos);
+
+    for (size_t x=0; x<models.size(); ++x) {
+        if (kind[x] == M_CELL) {
+            NameIndex *pins = new NameIndex();
+
+            for (size_t p=0; p<cells[x].pins.size(); ++p) {
+                pins->insert(cells[x].pins[p].name,static_cast<unsigned>(p));
+            }
+            model_cell[x] = _cells.size();
+            _models->insert(models[x],model_cell[x]);
+            _cell_pins.push_back(pins);
+            _cells.push_back(Cell());
+            _cells.back().model   = cells[x].model;
+            _cells.back().group   = cells[x].group;
+            _cells.back().library = cells[x].library;
+            _cells.back().pins.swap(cells[x].pins);
+        } else if (kind[x] == M_UNBOUND) {
+            _unbound.push_back(models[x]);
+        }
+    }
+
+    for (size_t i=0; i<ninsts; ++i) {
+        _port_first[i+1] += _port_first[i];
+    }
+    _inst_cell.assign(ninsts,npos);
+    _port_pin.assign(_port_first.back(),npos);
+
+    vector<size_t> unbound(ranges.size(),0);
+
+    pool.run(ranges.size(),[&](size_t t) {
+        const inst_range    &r  = ranges[t];
+        const VLP::InstList &il = ml[r.module]->get_instance_list();
+
+        for (unsigned i=r.begin; i<r.end; ++i) {
+            const unsigned model = addr_model[lower_bound(addrs.begin(),addrs.end(),il[i]->get_instance_module_name()) - addrs.begin()];
+            const unsigned inst  = _module_first[r.module] + i;
+            const unsigned cell  = model_cell[model];
+
+            unbound[t] += kind[model] == M_UNBOUND;
+            _inst_cell[inst] = cell;
+            if (cell == npos) {
+                continue;
+            }
+            const VLP::InstInterfaceList &ports = il[i]->get_ports();
+
+            for (size_t p=0; p<ports.size(); ++p) {
+                const char *formal = ports[p]->get_formal();
+
+                _port_pin[_port_first[inst] + p] = formal ? find_pin(&_cells[cell],formal) :
+                                                   (p < _cells[cell].pins.size() ? static_cast<unsigned>(p) : npos);
+            }
+        }
+    });
+    for (size_t t=0; t<unbound.size(); ++t) {
+        _unbound_insts += unbound[t];
+    }
+}
+
+NETLIB::Binding::~Binding()
+{
+    for (size_t x=0; x<_cell_pins.size(); ++x) {
+        delete _cell_pins[x];
+    }
+    delete _models;
+}
+
+unsigned NETLIB::Binding::get_first_inst(const VLP::Module *m) const
+{
+    vector<pair<const VLP::Module*,unsigned> >::const_iterator x =
+        lower_bound(_module_index.begin(),_module_index.end(),make_pair(m,0u));
+
+    return (x != _module_index.end() && x->first == m) ? _module_first[x->second] : npos;
+}
+
+const NETLIB::Binding::Pin *NETLIB::Binding::get_pin(const unsigned inst,const unsigned port) const
+{
+    const unsigned pin = _inst_cell[inst] == npos ? npos : _port_pin[_port_first[inst] + port];
+
+    return pin == npos ? 0 : &_cells[_inst_cell[inst]].pins[pin];
+}
+
+const NETLIB::Binding::Cell *NETLIB::Binding::find_cell(const char *model) const
+{
+    const unsigned x = _models->find(model);
+
+    return x == NameIndex::npos ? 0 : &_cells[x];
+}
+
+unsigned NETLIB::Binding::find_pin(const Cell *cell,const char *name) const
+{
+    const unsigned x = _cell_pins[cell - _cells.data()]->find(name);
+
+    return x == NameIndex::npos ? npos : x;
+}
+
+VLP::NetIndex::T_Dir NETLIB::Binding::pin_direction(const char *model,const char *formal,const unsigned position,void *user)
+{
+    const Binding *b    = static_cast<const Binding*>(user);
+    const Cell    *cell = b->find_cell(model);
+    const unsigned pin  = !cell ? npos : (formal ? b->find_pin(cell,formal) : position);
+
+    return (cell && pin < cell->pins.size()) ? cell->pins[pin].dir : VLP::NetIndex::D_UNKNOWN;
+}
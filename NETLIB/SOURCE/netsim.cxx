@@ -0,0 +1,455 @@
+// Netlist simulation
+// Author: David Berthelot
+
+#include <string.h>
+#include <map>
+#include "netsim.hxx"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NETLIB_SIM_AVX2
+#endif
+
+// The gates of a cell are the function attributes of its output pins, with
+// their inputs resolved to pins of the cell by the binding. Cells are
+// compiled once, on the first instance bound to them; the binding then maps
+// the ports of each instance to the pins.
+
+struct cell_gates {
+    vector<const DLIB::Function*> funcs;  // Function of each pin of the cell, 0 for inputs and for sequential outputs
+    vector<vector<unsigned> >     inputs; // Pin of each input of funcs[pin]
+    bool                          gates;  // Some pin has a function
+};
+
+// Functions that depend on something else than the pins (IQ, IQN of flip
+// flops and latches) are left out, their outputs are sources. Bus and
+// bundle groups have no gates.
+static cell_gates *compile_cell(const NETLIB::Binding *binding,const NETLIB::Binding::Cell *cell)
+{
+    cell_gates *c = new cell_gates;
+
+    c->gates = false;
+    c->funcs.assign(cell->pins.size(),static_cast<const DLIB::Function*>(0));
+    c->inputs.resize(cell->pins.size());
+    for (size_t x=0; x<cell->pins.size(); ++x) {
+        const DLIB::Group    *pin  = cell->pins[x].group;
+        const DLIB::Attr     *attr = strcmp(pin->get_name(),"pin") ? 0 : pin->find_attr("function");
+        const DLIB::Function *f    = attr ? attr->get_function() : 0;
+
+        for (unsigned i=0; f && i<f->get_inputs(); ++i) {
+            c->inputs[x].push_back(binding->find_pin(cell,f->get_input(i)));
+            f = (c->inputs[x].back() == NETLIB::Binding::npos) ? 0 : f;
+        }
+        c->funcs[x] = f;
+        c->gates    = c->gates || f;
+    }
+    return c;
+}
+
+// Gate primitives: the number of leading output terminals, 0 if model is
+// not a primitive. buf and not drive all their terminals but the last.
+static unsigned primitive_outputs(const char *model,const size_t nports)
+{
+    static const char *const single[] = {"and","nand","or","nor","xor","xnor"};
+
+    for (size_t x=0; x<sizeof(single)/sizeof(single[0]); ++x) {
+        if (strcmp(model,single[x]) == 0) {
+            return 1;
+        }
+    }
+    if (strcmp(model,"buf") == 0 || strcmp(model,"not") == 0) {
+        return nports > 1 ? nports - 1 : 1;
+    }
+    return 0;
+}
+
+// The function of a primitive of ninputs inputs, compiled from an expression
+// such as "!(i1 & i2)"
+static const DLIB::Function *primitive_function(const char *model,const unsigned ninputs,
+                                                map<string,const DLIB::Function*> *cache,vector<DLIB::Function*> *owned)
+{
+    const string key = string(model) + "/" + to_string(ninputs);
+
+    if (cache->count(key)) {
+        return (*cache)[key];
+    }
+    const bool   negate = model[0] == 'n' || !strcmp(model,"xnor");
+    const char  *op     = strstr(model,"and") ? " & " : (model[0] == 'x' ? " ^ " : " | ");
+    string       expr;
+
+    for (unsigned x=0; x<ninputs; ++x) {
+        expr += (x ? op : "") + string("i") + to_string(x + 1);
+    }
+    if (negate) {
+        expr = "!(" + expr + ")";
+    }
+    DLIB::Function *f = DLIB::compile_function_string(expr.c_str()).second;
+
+    if (f) {
+        owned->push_back(f);
+    }
+    return (*cache)[key] = f;
+}
+
+// The net of the leftmost bit of a port, X when it is not connected
+static unsigned port_net(const VLP::FlatDesign *flat,const unsigned inst,const unsigned port)
+{
+    return flat->get_port_width(inst,port) ? flat->get_port_nets(inst,port)[0] : unsigned(VLP::FlatDesign::NET_X);
+}
+
+// w[k] is the value of the gate when the inputs not yet selected have the
+// values of the bits of k, as in Function::evaluate(), on W words at once
+template <unsigned W>
+static inline __attribute__((always_inline)) void eval_table(const uint64_t table,const unsigned n,const unsigned *in,
+                                                              const uint64_t *values,uint64_t *out)
+{
+    uint64_t w[64][W];
+
+    for (unsigned k=0; k<(1u << n); ++k) {
+        const uint64_t v = -((table >> k) & 1);
+
+        for (unsigned j=0; j<W; ++j) {
+            w[k][j] = v;
+        }
+    }
+    for (int i=n-1; i>=0; --i) {
+        const uint64_t *sel = values + size_t(in[i]) * W;
+
+        for (unsigned k=0; k<(1u << i); ++k) {
+            for (unsigned j=0; j<W; ++j) {
+                w[k][j] = (w[k][j] & ~sel[j]) | (w[k + (1u << i)][j] & sel[j]);
+            }
+        }
+    }
+    for (unsigned j=0; j<W; ++j) {
+        out[j] = w[0][j];
+    }
+}
+
+template <unsigned W>
+static inline __attribute__((always_inline)) void eval_gates(const DLIB::Function *const *func,const unsigned *out,
+                                                              const unsigned *offset,const unsigned *inputs,const size_t ngates,
+                                                              uint64_t *values,uint64_t *scratch)
+{
+    for (size_t g=0; g<ngates; ++g) {
+        const unsigned *in = inputs + offset[g];
+        const unsigned  n  = offset[g+1] - offset[g];
+        uint64_t       *o  = values + size_t(out[g]) * W;
+
+        if (func[g]->has_truth_table()) {
+            eval_table<W>(func[g]->get_truth_table(),n,in,values,o);
+            continue;
+        }
+        for (unsigned j=0; j<W; ++j) {
+            for (unsigned i=0; i<n; ++i) {
+                scratch[i] = values[size_t(in[i]) * W + j];
+            }
+            o[j] = func[g]->evaluate(scratch);
+        }
+    }
+}
+
+static void eval_gates_1(const DLIB::Function *const *func,const unsigned *out,const unsigned *offset,const unsigned *inputs,
+                         const size_t ngates,uint64_t *values,uint64_t *scratch)
+{
+    eval_gates<1>(func,out,offset,inputs,ngates,values,scratch);
+}
+
+static void eval_gates_4(const DLIB::Function *const *func,const unsigned *out,const unsigned *offset,const unsigned *inputs,
+                         const size_t ngates,uint64_t *values,uint64_t *scratch)
+{
+    eval_gates<4>(func,out,offset,inputs,ngates,values,scratch);
+}
+
+#ifdef NETLIB_SIM_AVX2
+__attribute__((target("avx2")))
+static void eval_gates_4_avx2(const DLIB::Function *const *func,const unsigned *out,const unsigned *offset,const unsigned *inputs,
+                              const size_t ngates,uint64_t *values,uint64_t *scratch)
+{
+    eval_gates<4>(func,out,offset,inputs,ngates,values,scratch);
+}
+
+static bool has_avx2()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+
+    return avx2;
+}
+#endif
+
+static inline uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x  = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x  = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+
+//-----------------------------------------------------------------------------
+// Class Simulator
+//-----------------------------------------------------------------------------
+const unsigned NETLIB::Simulator::npos;
+
+NETLIB::Simulator::Simulator(const VLP::FlatDesign *flat,const Binding *binding,const unsigned words):
+    _flat(flat),_words(words <= 1 ? 1 : 4),_max_inputs(0),_unbound(0),_loops(0),_toggle_patterns(0)
+{
+    const size_t nets = flat->get_net_count();
+
+    _values.assign(nets * _words,0);
+    for (unsigned j=0; j<_words; ++j) {
+        _values[VLP::FlatDesign::NET_1 * _words + j] = ~uint64_t(0);
+    }
+    _driver.assign(nets,npos);
+
+    vector<cell_gates*>               cells(binding->get_cell_count(),static_cast<cell_gates*>(0));
+    map<string,const DLIB::Function*> prims;
+    vector<const DLIB::Function*>     func;
+    vector<unsigned>                  out,inputs,offset(1,0);
+    vector<unsigned>                  port_of;
+    unsigned                          path  = npos;
+    unsigned                          first = npos;
+
+    // Gates in instance order, a net driven twice keeps its first gate
+    for (unsigned i=0; i<flat->get_inst_count(); ++i) {
+        const VLP::Inst *inst   = flat->get_inst(i);
+        const char      *model  = inst->get_instance_module_name();
+        const unsigned   nports = flat->get_port_count(i);
+        const unsigned   nprim  = primitive_outputs(model,nports);
+        const size_t     before = out.size();
+
+        if (nprim) {
+            const unsigned nin = nports - nprim;
+
+            for (unsigned p=0; p<nprim && nin; ++p) {
+                const DLIB::Function *f   = primitive_function(model,nin,&prims,&_owned);
+                const unsigned        net = port_net(flat,i,p);
+
+                if (f && net >= VLP::FlatDesign::NET_FIRST && _driver[net] == npos) {
+                    for (unsigned x=nprim; x<nports; ++x) {
+                        inputs.push_back(port_net(flat,i,x));
+                    }
+                    _driver[net] = func.size();
+                    func.push_back(f);
+                    out.push_back(net);
+                    offset.push_back(inputs.size());
+                }
+            }
+            continue;
+        }
+        // The leaf instances of a path are consecutive
+        if (flat->get_inst_path(i) != path) {
+            path  = flat->get_inst_path(i);
+            first = binding->get_first_inst(flat->get_path_module(path));
+        }
+        const unsigned       b    = (first == Binding::npos) ? first : first + flat->get_inst_index(i);
+        const Binding::Cell *cell = (b == Binding::npos) ? 0 : binding->get_cell(b);
+        const size_t         id   = cell ? cell - &binding->get_cell_at(0) : 0;
+
+        if (cell && !cells[id]) {
+            cells[id] = compile_cell(binding,cell);
+        }
+        const cell_gates *c = cell ? cells[id] : 0;
+
+        if (c && c->gates) {
+            port_of.assign(cell->pins.size(),npos);
+            for (unsigned p=0; p<nports; ++p) {
+                const Binding::Pin *pin = binding->get_pin(b,p);
+
+                if (pin) {
+                    port_of[pin - cell->pins.data()] = p;
+                }
+            }
+            for (size_t k=0; k<cell->pins.size(); ++k) {
+                const unsigned net = (c->funcs[k] && port_of[k] != npos) ? port_net(flat,i,port_of[k]) : npos;
+
+                if (net == npos || net < VLP::FlatDesign::NET_FIRST || _driver[net] != npos) {
+                    continue;
+                }
+                for (size_t x=0; x<c->inputs[k].size(); ++x) {
+                    const unsigned p = port_of[c->inputs[k][x]];
+
+                    inputs.push_back(p == npos ? unsigned(VLP::FlatDesign::NET_X) : port_net(flat,i,p));
+                }
+                _driver[net] = func.size();
+                func.push_back(c->funcs[k]);
+                out.push_back(net);
+                offset.push_back(inputs.size());
+            }
+        }
+        _unbound += (out.size() == before);
+    }
+    for (size_t x=0; x<cells.size(); ++x) {
+        delete cells[x];
+    }
+    levelize(func,out,offset,inputs);
+}
+
+NETLIB::Simulator::~Simulator()
+{
+    for (size_t x=0; x<_owned.size(); ++x) {
+        delete _owned[x];
+    }
+}
+
+// Kahn's algorithm on the gates. When only gates of loops are left, one of
+// them is cut: its output becomes a source and its readers may proceed.
+void NETLIB::Simulator::levelize(const vector<const DLIB::Function*> &func,const vector<unsigned> &out,
+                                 const vector<unsigned> &offset,const vector<unsigned> &inputs)
+{
+    const size_t     ngates = func.size();
+    const size_t     nets   = _driver.size();
+    vector<unsigned> readers_offset(nets + 1,0),readers(inputs.size());
+    vector<unsigned> pending(ngates,0),level(ngates,0),queue;
+    vector<bool>     cut(ngates,false);
+
+    for (size_t x=0; x<inputs.size(); ++x) {
+        ++readers_offset[inputs[x] + 1];
+    }
+    for (size_t x=0; x<nets; ++x) {
+        readers_offset[x+1] += readers_offset[x];
+    }
+    vector<unsigned> next(readers_offset.begin(),readers_offset.end() - 1);
+
+    for (unsigned g=0; g<ngates; ++g) {
+        for (unsigned x=offset[g]; x<offset[g+1]; ++x) {
+            readers[next[inputs[x]]++] = g;
+            pending[g] += _driver[inputs[x]] != npos;
+        }
+        if (!pending[g]) {
+            queue.push_back(g);
+        }
+    }
+    size_t   head = 0,scan = 0;
+    unsigned depth = 0;
+
+    for (;;) {
+        for (; head<queue.size(); ++head) {
+            const unsigned g = queue[head];
+            const unsigned n = out[g];
+
+            depth = cut[g] ? depth : max(depth,level[g] + 1);
+            for (unsigned x=readers_offset[n]; x<readers_offset[n+1]; ++x) {
+                const unsigned r = readers[x];
+
+                level[r] = max(level[r],cut[g] ? 0 : level[g] + 1);
+                if (--pending[r] == 0 && !cut[r]) {
+                    queue.push_back(r);
+                }
+            }
+        }
+        if (queue.size() == ngates) {
+            break;
+        }
+        for (; pending[scan] == 0 || cut[scan]; ++scan);
+        cut[scan] = true;
+        ++_loops;
+        queue.push_back(scan);
+    }
+    // Gates sorted by level, the cut gates are dropped
+    _levels.assign(depth + 1,0);
+    for (unsigned g=0; g<ngates; ++g) {
+        if (!cut[g]) {
+            ++_levels[level[g] + 1];
+        }
+    }
+    for (unsigned l=0; l<depth; ++l) {
+        _levels[l+1] += _levels[l];
+    }
+    vector<unsigned> order(ngates),slot(_levels.begin(),_levels.end() - 1);
+    const size_t     kept = _levels.back();
+
+    for (unsigned g=0; g<ngates; ++g) {
+        if (!cut[g]) {
+            order[slot[level[g]]++] = g;
+        }
+    }
+    _gate_func.resize(kept);
+    _gate_out.resize(kept);
+    _gate_offset.assign(1,0);
+    for (size_t x=0; x<kept; ++x) {
+        const unsigned g = order[x];
+
+        _gate_func[x] = func[g];
+        _gate_out[x]  = out[g];
+        _gate_inputs.insert(_gate_inputs.end(),inputs.begin() + offset[g],inputs.begin() + offset[g+1]);
+        _gate_offset.push_back(_gate_inputs.size());
+        _max_inputs = max(_max_inputs,offset[g+1] - offset[g]);
+    }
+    _driver.assign(nets,npos);
+    for (size_t x=0; x<kept; ++x) {
+        _driver[_gate_out[x]] = x;
+    }
+    for (unsigned n=VLP::FlatDesign::NET_FIRST; n<nets; ++n) {
+        if (_driver[n] == npos) {
+            _sources.push_back(n);
+        }
+    }
+}
+
+void NETLIB::Simulator::set_source(const unsigned net,const uint64_t *values)
+{
+    memcpy(&_values[size_t(net) * _words],values,_words * sizeof(uint64_t));
+}
+
+void NETLIB::Simulator::randomize(const uint64_t seed)
+{
+    const uint64_t base = splitmix64(seed);
+
+    for (size_t x=0; x<_sources.size(); ++x) {
+        uint64_t *v = &_values[size_t(_sources[x]) * _words];
+
+        for (unsigned j=0; j<_words; ++j) {
+            v[j] = splitmix64(base ^ (uint64_t(x) * _words + j) * 0xD1B54A32D192ED03ULL);
+        }
+    }
+}
+
+void NETLIB::Simulator::run()
+{
+    vector<uint64_t> scratch(_max_inputs + 1);
+
+    if (!_gate_func.empty()) {
+        const DLIB::Function *const *f = _gate_func.data();
+
+        if (_words == 1) {
+            eval_gates_1(f,_gate_out.data(),_gate_offset.data(),_gate_inputs.data(),_gate_func.size(),_values.data(),scratch.data());
+#ifdef NETLIB_SIM_AVX2
+        } else if (has_avx2()) {
+            eval_gates_4_avx2(f,_gate_out.data(),_gate_offset.data(),_gate_inputs.data(),_gate_func.size(),_values.data(),scratch.data());
+#endif
+        } else {
+            eval_gates_4(f,_gate_out.data(),_gate_offset.data(),_gate_inputs.data(),_gate_func.size(),_values.data(),scratch.data());
+        }
+    }
+    if (!_toggles.empty()) {
+        add_toggles();
+    }
+}
+
+void NETLIB::Simulator::count_toggles()
+{
+    _toggles.assign(_driver.size(),0);
+    _last.assign(_driver.size(),2);
+    _toggle_patterns = 0;
+}
+
+// A net toggles where its value differs from its value one pattern before,
+// the value before pattern 0 is the last of the previous pass (2 if none)
+void NETLIB::Simulator::add_toggles()
+{
+    const bool first = _last[0] == 2;
+
+    for (size_t n=0; n<_toggles.size(); ++n) {
+        const uint64_t *v = &_values[n * _words];
+        uint64_t        t = 0;
+
+        for (unsigned j=0; j<_words; ++j) {
+            const uint64_t before = (v[j] << 1) | (j ? v[j-1] >> 63 : (_last[n] & 1));
+
+            t += __builtin_popcountll((v[j] ^ before) & ((j || !first) ? ~uint64_t(0) : ~uint64_t(1)));
+        }
+        _toggles[n] += t;
+        _last[n]     = v[_words - 1] >> 63;
+    }
+    _toggle_patterns += get_patterns() - first;
+}
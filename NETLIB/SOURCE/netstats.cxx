@@ -0,0 +1,213 @@
+// Netlist hierarchy statistics
+// Author: David Berthelot
+
+#include <string.h>
+#include <algorithm>
+#include "netstats.hxx"
+#include "ThreadPool.hxx"
+
+// Each module is counted alone, on the threads of the pool: its models are
+// sorted and counted once each, then bound to a module of the design or to
+// the cell of the binding. The modules are then rolled up by levels: a
+// level holds the modules whose submodules are all rolled up, so its
+// modules are independent of each other. The models of the leaf instances
+// are merged by address during the roll up, sorted by name at the end.
+// The modules left out of the levels are on or above a cycle.
+
+typedef vector<pair<const char*,uint64_t> > model_counts;
+
+struct submodule {
+    unsigned module;
+    uint64_t count;
+};
+
+static double number_attr(const DLIB::Group *g,const char *name)
+{
+    const DLIB::Attr *a = g->find_attr(name);
+
+    return (a && a->get_type() == DLIB::Arg::T_NUMBER) ? a->get_number() : 0.0;
+}
+
+static bool by_name(const pair<const char*,uint64_t> &a,const pair<const char*,uint64_t> &b)
+{
+    return strcmp(a.first,b.first) < 0;
+}
+
+// Adds the counts of from, count times, to the counts of to, both sorted by address
+static void merge_counts(model_counts *to,const model_counts &from,const uint64_t count)
+{
+    model_counts           merged;
+    model_counts::iterator x = to->begin();
+
+    merged.reserve(to->size() + from.size());
+    for (model_counts::const_iterator y=from.begin(); y!=from.end(); ++y) {
+        for (; x != to->end() && x->first < y->first; ++x) {
+            merged.push_back(*x);
+        }
+        if (x != to->end() && x->first == y->first) {
+            merged.push_back(make_pair(y->first,x->second + count * y->second));
+            ++x;
+        } else {
+            merged.push_back(make_pair(y->first,count * y->second));
+        }
+    }
+    merged.insert(merged.end(),x,to->end());
+    to->swap(merged);
+}
+
+
+//-----------------------------------------------------------------------------
+// Class HierarchyStats
+//-----------------------------------------------------------------------------
+NETLIB::HierarchyStats::HierarchyStats(const VLP::Design *design,const Binding *binding,const unsigned nthreads)
+{
+    const VLP::ModuleList     &ml = design->get_modules();
+    ThreadPool                 pool(nthreads);
+    vector<vector<submodule> > subs(ml.size());
+    const size_t               ncells = binding ? binding->get_cell_count() : 0;
+    vector<double>             cell_area(ncells),cell_leakage(ncells);
+
+    for (unsigned m=0; m<ml.size(); ++m) {
+        _module_index.push_back(make_pair(ml[m],m));
+    }
+    sort(_module_index.begin(),_module_index.end());
+    pool.run(ncells,[&](size_t c) {
+        cell_area[c]    = number_attr(binding->get_cell_at(c).group,"area");
+        cell_leakage[c] = number_attr(binding->get_cell_at(c).group,"cell_leakage_power");
+    });
+
+    _local.resize(ml.size());
+    pool.run(ml.size(),[&](size_t m) {
+        const VLP::InstList &il = ml[m]->get_instance_list();
+        Stats               &s  = _local[m];
+        vector<const char*>  names;
+
+        names.reserve(il.size());
+        for (size_t i=0; i<il.size(); ++i) {
+            names.push_back(il[i]->get_instance_module_name());
+        }
+        sort(names.begin(),names.end());
+        s.instances      = il.size();
+        s.leaf_instances = s.unbound_instances = 0;
+        s.area           = s.leakage = 0;
+        s.depth          = 1;
+        for (size_t b=0,e; b<names.size(); b=e) {
+            for (e=b+1; e<names.size() && names[e] == names[b]; ++e);
+
+            const uint64_t     count = e - b;
+            const VLP::Module *sub   = design->get_module(names[b]);
+
+            if (sub) {
+                const submodule x = {
+                    lower_bound(_module_index.begin(),_module_index.end(),make_pair(sub,0u))->second,count
+                };
+
+                subs[m].push_back(x);
+                continue;
+            }
+            const Binding::Cell *cell = binding ? binding->find_cell(names[b]) : 0;
+
+            s.leaf_instances += count;
+            s.models.push_back(make_pair(names[b],count));
+            if (cell) {
+                const size_t c = cell - &binding->get_cell_at(0);
+
+                s.area    += count * cell_area[c];
+                s.leakage += count * cell_leakage[c];
+            } else {
+                s.unbound_instances += count;
+            }
+        }
+    });
+
+    // Distinct submodule indexes, then the modules instantiating each one
+    vector<unsigned> pending(ml.size()),parent_first(ml.size() + 1,0),parents;
+    vector<unsigned> level;
+
+    for (unsigned m=0; m<ml.size(); ++m) {
+        sort(subs[m].begin(),subs[m].end(),[](const submodule &a,const submodule &b) {return a.module < b.module;});
+
+        size_t n = 0;
+
+        for (size_t x=0; x<subs[m].size(); ++x) {
+            if (n && subs[m][n-1].module == subs[m][x].module) {
+                subs[m][n-1].count += subs[m][x].count;
+            } else {
+                subs[m][n++] = subs[m][x];
+            }
+        }
+        subs[m].resize(n);
+        pending[m] = n;
+        for (size_t x=0; x<n; ++x) {
+            ++parent_first[subs[m][x].module + 1];
+        }
+        if (!n) {
+            level.push_back(m);
+        }
+    }
+    for (size_t m=0; m<ml.size(); ++m) {
+        parent_first[m+1] += parent_first[m];
+    }
+    parents.resize(parent_first.back());
+    {
+        vector<unsigned> fill(parent_first.begin(),parent_first.end() - 1);
+
+        for (unsigned m=0; m<ml.size(); ++m) {
+            for (size_t x=0; x<subs[m].size(); ++x) {
+                parents[fill[subs[m][x].module]++] = m;
+            }
+        }
+    }
+
+    _stats.resize(ml.size());
+    _valid.assign(ml.size(),0);
+    while (!level.empty()) {
+        vector<unsigned> next;
+
+        pool.run(level.size(),[&](size_t x) {
+            const unsigned m = level[x];
+            Stats         &s = _stats[m];
+
+            s = _local[m];
+            for (size_t y=0; y<subs[m].size(); ++y) {
+                const Stats   &sub   = _stats[subs[m][y].module];
+                const uint64_t count = subs[m][y].count;
+
+                s.instances         += count * sub.instances;
+                s.leaf_instances    += count * sub.leaf_instances;
+                s.unbound_instances += count * sub.unbound_instances;
+                s.area              += count * sub.area;
+                s.leakage           += count * sub.leakage;
+                s.depth              = max(s.depth,sub.depth + 1);
+                merge_counts(&s.models,sub.models,count);
+            }
+        });
+        for (size_t x=0; x<level.size(); ++x) {
+            _valid[level[x]] = 1;
+            for (unsigned p=parent_first[level[x]]; p<parent_first[level[x]+1]; ++p) {
+                if (!--pending[parents[p]]) {
+                    next.push_back(parents[p]);
+                }
+            }
+        }
+        level.swap(next);
+    }
+
+    pool.run(ml.size(),[&](size_t m) {
+        sort(_local[m].models.begin(),_local[m].models.end(),by_name);
+        sort(_stats[m].models.begin(),_stats[m].models.end(),by_name);
+    });
+    for (unsigned m=0; m<ml.size(); ++m) {
+        if (!_valid[m]) {
+            _recursive.push_back(ml[m]->get_name());
+        }
+    }
+}
+
+const NETLIB::HierarchyStats::Stats *NETLIB::HierarchyStats::get_stats(const VLP::Module *m) const
+{
+    vector<pair<const VLP::Module*,unsigned> >::const_iterator x =
+        lower_bound(_module_index.begin(),_module_index.end(),make_pair(m,0u));
+
+    return (x != _module_index.end() && x->first == m) ? get_stats(x->second) : 0;
+}
@@ -0,0 +1,95 @@
+// Lexeme Table contention benchmark
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "LexemeTable.hxx"
+
+// Every thread interns the same set of names in a different order, the
+// way parallel lexers reading blocks of one design do. The run checks
+// that all the threads got the same pointer for the same name.
+
+static mutex global_lock;
+
+static void intern(LexemeTable *t,const bool locked,const vector<string> *names,
+                   const size_t lookups,const unsigned seed,vector<const char*> *seen)
+{
+    const size_t n = names->size();
+    size_t       k = seed;
+
+    for (size_t x=0; x<lookups; ++x) {
+        const string &s = (*names)[k];
+        const char   *p;
+
+        if (locked) {
+            lock_guard<mutex> g(global_lock);
+            p = t->get(s.c_str(),s.size());
+        } else {
+            p = t->get(s.c_str(),s.size());
+        }
+        (*seen)[k] = p;
+        k = (k + 7919) % n;
+    }
+}
+
+static bool run(const char *title,const bool concurrent,const unsigned nthreads,
+                const vector<string> &names,const size_t lookups)
+{
+    LexemeTable                 t(concurrent);
+    vector<vector<const char*> > seen(nthreads,vector<const char*>(names.size(),static_cast<const char*>(0)));
+    vector<thread>              workers;
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned x=0; x<nthreads; ++x) {
+        workers.push_back(thread(intern,&t,!concurrent,&names,lookups,x * 104729 % names.size(),&seen[x]));
+    }
+    for (unsigned x=0; x<nthreads; ++x) {
+        workers[x].join();
+    }
+    const double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    bool isok = t.size() == names.size();
+    for (size_t k=0; k<names.size(); ++k) {
+        const char *p = 0;
+
+        for (unsigned x=0; x<nthreads; ++x) {
+            if (!seen[x][k]) {
+                continue;
+            }
+            if (!p) {
+                p = seen[x][k];
+            }
+            isok = isok && seen[x][k] == p && names[k] == p;
+        }
+    }
+    printf("%-24s %2u threads %8.2f Mlookups/s %s\n",title,nthreads,
+           nthreads * lookups / secs / 1e6,isok ? "ok" : "MISMATCH");
+    return isok;
+}
+
+int main(int argc,char **argv)
+{
+    const unsigned nthreads = argc > 1 ? atoi(argv[1]) : thread::hardware_concurrency();
+    const size_t   nnames   = argc > 2 ? atol(argv[2]) : 1000000;
+    const size_t   lookups  = argc > 3 ? atol(argv[3]) : 4000000;
+    vector<string> names;
+    char           buf[64];
+
+    for (size_t x=0; x<nnames; ++x) {
+        snprintf(buf,sizeof(buf),"u_core/blk%zu/n%zu",x % 97,x);
+        names.push_back(buf);
+    }
+    printf("%zu names, %zu lookups per thread\n",nnames,lookups);
+
+    bool isok = true;
+    for (unsigned n=1; n<=(nthreads ? nthreads : 1); n*=2) {
+        isok = run("single table + mutex",false,n,names,lookups) && isok;
+        isok = run("sharded table",true,n,names,lookups) && isok;
+    }
+    return isok ? 0 : 1;
+}
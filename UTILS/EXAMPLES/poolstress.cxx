@@ -0,0 +1,52 @@
+// Thread Pool stress test
+// Author: David Berthelot
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "ThreadPool.hxx"
+
+// Usage: poolstress.exe [-n runs] [-t threads]
+//   Issues many run() back to back with a few tasks each, the way the
+//   binding and the hierarchy statistics do, each with its own task and
+//   counters that are gone once run() returns. Every index must have run
+//   exactly once by then. Build with -fsanitize=address or thread to also
+//   catch a worker calling a task of a previous run().
+int main(int argc,char **argv)
+{
+    size_t   runs     = 200000;
+    unsigned nthreads = 4;
+
+    for (int x=1; x<argc; ++x) {
+        if (!strcmp(argv[x],"-n") && x+1 < argc) {
+            runs = strtoul(argv[++x],0,10);
+        } else if (!strcmp(argv[x],"-t") && x+1 < argc) {
+            nthreads = atoi(argv[++x]);
+        } else {
+            printf("Usage: %s [-n runs] [-t threads]\n",argv[0]);
+            return 1;
+        }
+    }
+    ThreadPool pool(nthreads);
+    size_t     bad = 0;
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (size_t r=0; r<runs; ++r) {
+        const size_t                 ntasks = 2 + r % 7;
+        vector<atomic<unsigned> >   *hits   = new vector<atomic<unsigned> >(ntasks);
+        const function<void(size_t)> task   = [hits,r](const size_t x) {(*hits)[x] += 1 + static_cast<unsigned>(r % 3);};
+
+        pool.run(ntasks,task);
+        for (size_t x=0; x<ntasks; ++x) {
+            bad += (*hits)[x] != 1 + r % 3;
+        }
+        delete hits;
+    }
+    const double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    printf("%zu runs on %u threads in %.3f s (%.2f us per run), %zu indices wrong\n",runs,pool.size(),secs,1e6 * secs / runs,bad);
+    return bad ? 1 : 0;
+}
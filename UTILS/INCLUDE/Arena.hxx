@@ -0,0 +1,59 @@
+// Arena (bump allocator)
+// Author: David Berthelot
+
+#ifndef ARENA_ALLOCATOR
+#define ARENA_ALLOCATOR
+
+#include <stddef.h>
+
+// Memory handed out by an arena is never freed individually, it is all
+// released at once when the arena is released or destroyed. Addresses
+// are stable for the lifetime of the arena.
+class Arena
+{
+public:
+    Arena(const size_t block_size=64*1024);
+    ~Arena();
+
+    void   *allocate(const size_t size,const size_t align=sizeof(void*));
+    char   *copy(const char *text,const size_t len); // Copies len chars and appends a '\0'
+    void    release();
+    void    rewind();                                // As release(), but keeps the current block to serve the next allocations
+    void    adopt(Arena &other);                     // Takes over the blocks of other, which is left empty
+    size_t  get_allocated() const; // Bytes handed out
+    size_t  get_reserved()  const; // Bytes obtained from the system
+
+private:
+    struct block;
+
+    block  *_blocks;
+    char   *_cur;
+    char   *_end;
+    size_t  _block_size;
+    size_t  _allocated;
+    size_t  _reserved;
+
+    void   *allocate_slow(const size_t size,const size_t align);
+
+    Arena(const Arena&);
+    Arena &operator=(const Arena&);
+};
+
+inline void *Arena::allocate(const size_t size,const size_t align)
+{
+    char *p = reinterpret_cast<char*>((reinterpret_cast<size_t>(_cur) + align - 1) & ~(align - 1));
+
+    if (_end && p + size <= _end) {
+        _cur        = p + size;
+        _allocated += size;
+        return p;
+    }
+    return allocate_slow(size,align);
+}
+
+// Placement in an arena: new (arena) T(...). Objects placed this way are
+// never deleted, their destructor is not run when the arena is released.
+inline void *operator new(size_t size,Arena &arena) {return arena.allocate(size);}
+inline void  operator delete(void *,Arena &)        {}
+
+#endif
@@ -4,22 +4,41 @@
 #ifndef  LEXEME_TABLE
 #define  LEXEME_TABLE
 
-#include <set>
+#include <stddef.h>
 #include <string>
+#include <type_traits>
 
 using namespace std;
 
-class LexemeTable 
+// Interns strings: equal strings always return the same pointer, so
+// lexemes can be compared by address. Pointers stay valid for the
+// lifetime of the table. Case insensitive lookups fold to lower case.
+// A concurrent table is split in independently locked shards and can be
+// shared by several threads (e.g. one lexer per thread).
+class LexemeTable
 {
 public:
-    LexemeTable();
+    LexemeTable(const bool concurrent=false);
     ~LexemeTable();
 
     const char *get(const char *text,const bool case_sensitive=true);
+    const char *get(const char *text,const size_t len,const bool case_sensitive=true);
+    // Lengths of any other integer type go to the size_t overload rather than being taken for the case flag
+    template <class N> typename enable_if<is_integral<N>::value && !is_same<N,bool>::value,const char*>::type
+                get(const char *text,const N len,const bool case_sensitive=true) {return get(text,static_cast<size_t>(len),case_sensitive);}
+    const char *adopt(const char *text,const size_t len); // As get() without copying: text[len] must be '\0' and text must outlive the table
+    size_t      size()  const;
     void        print() const;
+    bool        is_concurrent() const {return _nshards > 1;}
 
 private:
-    set<string> _text;
+    struct shard;
+
+    shard   *_shards;
+    unsigned _nshards;
+
+    LexemeTable(const LexemeTable&);
+    LexemeTable &operator=(const LexemeTable&);
 };
 
 #endif
@@ -0,0 +1,35 @@
+// Memory mapped file
+// Author: David Berthelot
+
+#ifndef MAPPED_FILE
+#define MAPPED_FILE
+
+#include <stddef.h>
+
+// Maps a whole regular file in memory for sequential reading. The mapping
+// is private: writes are allowed and never reach the file. The requested
+// padding is zero filled past the end of the data, scanners such as
+// flex's yy_scan_buffer need two such bytes to detect the end of buffer.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Returns false when the file can't be mapped (pipes, terminals,...),
+    // callers should then fall back to stdio.
+    bool    open(const char *filename,const size_t padding=0);
+    void    close();
+    char   *data() const {return _data;}
+    size_t  size() const {return _size;}
+
+private:
+    char   *_data;
+    size_t  _size;
+    size_t  _mapped;
+
+    MappedFile(const MappedFile&);
+    MappedFile &operator=(const MappedFile&);
+};
+
+#endif
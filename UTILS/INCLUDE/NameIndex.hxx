@@ -0,0 +1,49 @@
+// Name Index
+// Author: David Berthelot
+
+#ifndef NAME_INDEX
+#define NAME_INDEX
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+using namespace std;
+
+// Maps names to dense ids. The names are not copied, they must outlive the
+// index (typically they are lexemes). Once filled the index is only read,
+// so any number of threads may call find() at the same time, and a failed
+// find() changes nothing. A case insensitive index folds names to lower
+// case when hashing and comparing them.
+class NameIndex
+{
+public:
+    static const unsigned npos = ~0u;
+
+    NameIndex(const bool case_sensitive=true);
+
+    void     reserve(const size_t n);
+    unsigned insert(const char *name,const unsigned id);                  // Returns the id of name, the first id when name was already present
+    unsigned insert(const char *name,const size_t len,const unsigned id);
+    unsigned find(const char *name) const {return find(name,strlen(name));} // npos if absent
+    unsigned find(const char *name,const size_t len) const;
+    size_t   size() const {return _count;}
+
+private:
+    struct slot {
+        const char   *text;
+        unsigned int  hash;
+        unsigned int  len;
+        unsigned int  id;
+    };
+
+    vector<slot> _slots;
+    size_t       _mask;
+    size_t       _count;
+    bool         _case_sensitive;
+
+    void         grow(const size_t nslots);
+    bool         same(const slot &s,const char *name,const size_t len) const;
+};
+
+#endif
@@ -0,0 +1,108 @@
+// Sectioned binary file
+// Author: David Berthelot
+
+#ifndef SECTION_FILE
+#define SECTION_FILE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include "MappedFile.hxx"
+#include "NameIndex.hxx"
+
+using namespace std;
+
+// A binary file made of a header and of sections of fixed size records,
+// all integers in the byte order of the writer:
+//   header: magic, version, byte order mark, size of the file, number of
+//   sections, size of the format's own header
+//   count (records) and offset of each section
+//   the format's own header, if any
+//   sections, each 8 bytes aligned
+// The first two sections are the strings, NUL terminated, and the offset
+// of each string. Records refer to strings and to each other by index,
+// none stands for a missing string or record.
+namespace SectionFile {
+    static const uint32_t none = ~0u;
+
+    enum {STRINGS,          // Bytes
+          OFFSETS,          // uint32_t
+          FIRST_SECTION};   // First section of the format
+};
+
+// The strings are added while the records are built, the file is then
+// written in one go: open(), one write() per section in order, close().
+class SectionWriter
+{
+public:
+    SectionWriter();
+    ~SectionWriter();
+
+    uint32_t add_string(const char *s);        // Returns the index of s, none for a null string
+    size_t   get_string_bytes() const {return _strings.size();}
+
+    // Writes the header and the strings, extra is the format's own header
+    bool     open(const char *path,const char magic[8],const uint32_t version,const unsigned nsections,
+                  const void *extra=0,const size_t extra_size=0);
+    template <class T> bool write(const vector<T> &v) {return write(v.empty() ? 0 : v.data(),sizeof(T),v.size());}
+    bool     write(const void *records,const size_t record_size,const size_t count);
+    // Places the sections in the header, returns false if anything failed since open()
+    bool     close();
+
+private:
+    NameIndex         _ids;
+    vector<char>      _strings;
+    vector<uint32_t>  _offsets;
+    FILE             *_file;
+    vector<uint64_t>  _table;       // Counts then offsets
+    unsigned          _written;
+    bool              _isok;
+
+    SectionWriter(const SectionWriter&);
+    SectionWriter &operator=(const SectionWriter&);
+};
+
+// Maps a file and checks that its header and sections lie within it, and
+// that the strings are terminated. The indexes read from the sections are
+// checked with valid() and string(): a bad one clears is_ok() for good.
+class SectionReader
+{
+public:
+    enum T_Status {R_OK,            // The file can be read
+                   R_MISSING,       // No such file
+                   R_FOREIGN,       // Another format, version or byte order
+                   R_CORRUPTED};    // Truncated or inconsistent
+
+    SectionReader();
+
+    // record_size gives the size of the records of the sections from FIRST_SECTION on
+    T_Status     open(const char *path,const char magic[8],const uint32_t version,const unsigned nsections,
+                      const size_t *record_size,const size_t extra_size=0);
+    const void  *get_extra() const {return _extra;}
+
+    template <class T> const T *section(const unsigned s) const {return reinterpret_cast<const T*>(_file.data() + _offset[s]);}
+    uint64_t     count(const unsigned s) const {return _count[s];}
+    bool         valid(const uint32_t x,const unsigned s,const uint32_t n=1) {_isok = _isok && x <= _count[s] && n <= _count[s] - x; return _isok;}
+    bool         below(const uint32_t x,const uint32_t limit)               {_isok = _isok && x < limit; return _isok;}
+    void         fail() {_isok = false;}
+    bool         is_ok() const {return _isok;}
+
+    // Strings stay in the mapping, which lasts as long as the reader
+    size_t       get_string_count() const {return _count[SectionFile::OFFSETS];}
+    const char  *get_string_pool() const {return section<char>(SectionFile::STRINGS);}
+    size_t       get_string_pool_size() const {return _count[SectionFile::STRINGS];}
+    const char  *string(const uint32_t x) {return x != SectionFile::none && valid(x,SectionFile::OFFSETS) ? get_string_pool() + _strings[x] : 0;}
+
+private:
+    MappedFile       _file;
+    const uint64_t  *_count;
+    const uint64_t  *_offset;
+    const void      *_extra;
+    const uint32_t  *_strings;
+    bool             _isok;
+
+    SectionReader(const SectionReader&);
+    SectionReader &operator=(const SectionReader&);
+};
+
+#endif
@@ -0,0 +1,33 @@
+// Text hashing shared by the string tables
+// Author: David Berthelot
+
+#ifndef TEXT_HASH
+#define TEXT_HASH
+
+#include <stddef.h>
+
+static inline unsigned char lower_ascii(const unsigned char c)
+{
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+}
+
+// FNV-1a, folded to 32 bits. Case folding is done while hashing so that
+// case insensitive lookups need no temporary copy.
+static inline unsigned int hash_text(const char *text,const size_t len,const bool case_sensitive=true)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(text);
+    unsigned long long   h = 14695981039346656037ULL;
+
+    if (case_sensitive) {
+        for (size_t i=0; i<len; ++i) {
+            h = (h ^ p[i]) * 1099511628211ULL;
+        }
+    } else {
+        for (size_t i=0; i<len; ++i) {
+            h = (h ^ lower_ascii(p[i])) * 1099511628211ULL;
+        }
+    }
+    return static_cast<unsigned int>(h ^ (h >> 32));
+}
+
+#endif
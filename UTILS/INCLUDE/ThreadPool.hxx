@@ -0,0 +1,33 @@
+// Thread Pool
+// Author: David Berthelot
+
+#ifndef THREAD_POOL
+#define THREAD_POOL
+
+#include <stddef.h>
+#include <functional>
+
+using namespace std;
+
+// A fixed set of worker threads running indexed tasks. run() hands out the
+// indices 0..ntasks-1 to the workers (the calling thread helps too) and
+// returns once they are all done. A run() issued from inside a task, or
+// while another thread is using the pool, executes inline on the caller.
+class ThreadPool
+{
+public:
+    ThreadPool(const unsigned nthreads=0); // 0: one thread per hardware thread
+    ~ThreadPool();
+
+    void     run(const size_t ntasks,const function<void(size_t)> &task);
+    unsigned size() const;
+
+private:
+    struct data;
+    data *_data;
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool &operator=(const ThreadPool&);
+};
+
+#endif
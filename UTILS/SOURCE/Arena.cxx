@@ -0,0 +1,122 @@
+// Arena (bump allocator)
+// Author: David Berthelot
+
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "Arena.hxx"
+
+struct Arena::block {
+    block *next;
+    size_t size;
+};
+
+Arena::Arena(const size_t block_size):
+    _blocks(0),_cur(0),_end(0),_block_size(block_size),_allocated(0),_reserved(0)
+{
+}
+
+Arena::~Arena()
+{
+    release();
+}
+
+void *Arena::allocate_slow(const size_t size,const size_t align)
+{
+    // Large requests get a block of their own so that the current block
+    // keeps serving small ones.
+    const size_t need  = sizeof(block) + size + align;
+    const size_t bsize = need > _block_size ? need : _block_size;
+    block       *b     = static_cast<block*>(malloc(bsize));
+
+    if (!b) {
+        throw std::bad_alloc();
+    }
+    b->size    = bsize;
+    _reserved += bsize;
+
+    char *start = reinterpret_cast<char*>(b + 1);
+    char *p     = reinterpret_cast<char*>((reinterpret_cast<size_t>(start) + align - 1) & ~(align - 1));
+
+    if (need > _block_size && _blocks) {
+        b->next         = _blocks->next;
+        _blocks->next   = b;
+    } else {
+        b->next = _blocks;
+        _blocks = b;
+        _cur    = p + size;
+        _end    = reinterpret_cast<char*>(b) + bsize;
+    }
+    _allocated += size;
+    return p;
+}
+
+char *Arena::copy(const char *text,const size_t len)
+{
+    char *p = static_cast<char*>(allocate(len + 1,1));
+
+    memcpy(p,text,len);
+    p[len] = 0;
+    return p;
+}
+
+void Arena::release()
+{
+    while (_blocks) {
+        block *next = _blocks->next;
+        free(_blocks);
+        _blocks = next;
+    }
+    _cur       = 0;
+    _end       = 0;
+    _allocated = 0;
+    _reserved  = 0;
+}
+
+void Arena::rewind()
+{
+    if (!_blocks) {
+        return;
+    }
+    while (_blocks->next) {
+        block *next = _blocks->next->next;
+        free(_blocks->next);
+        _blocks->next = next;
+    }
+    _cur       = reinterpret_cast<char*>(_blocks + 1);
+    _end       = reinterpret_cast<char*>(_blocks) + _blocks->size;
+    _allocated = 0;
+    _reserved  = _blocks->size;
+}
+
+// The adopted blocks are chained after the current block so that it keeps
+// serving allocations.
+void Arena::adopt(Arena &other)
+{
+    if (!other._blocks) {
+        return;
+    }
+    if (_blocks) {
+        block *last = other._blocks;
+
+        while (last->next) {
+            last = last->next;
+        }
+        last->next     = _blocks->next;
+        _blocks->next  = other._blocks;
+    } else {
+        _blocks = other._blocks;
+        _cur    = other._cur;
+        _end    = other._end;
+    }
+    _allocated       += other._allocated;
+    _reserved        += other._reserved;
+    other._blocks     = 0;
+    other._cur        = 0;
+    other._end        = 0;
+    other._allocated  = 0;
+    other._reserved   = 0;
+}
+
+size_t Arena::get_allocated() const {return _allocated;}
+size_t Arena::get_reserved()  const {return _reserved;}
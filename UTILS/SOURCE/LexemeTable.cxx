@@ -2,52 +2,205 @@
 // Author: David Berthelot
 
 #include <stdio.h>
-#include "LexemeTable.hxx"
+#include <stdlib.h>
+#include <string.h>
 #include <algorithm>
+#include <vector>
+#include <mutex>
+#include "Arena.hxx"
+#include "TextHash.hxx"
+#include "LexemeTable.hxx"
+
+// Open addressing with linear probing, the table is kept at most 70% full.
+// Strings live in an arena so growing the table never moves them.
+
+static const size_t initial_slots = 256;
 
-LexemeTable::LexemeTable()
+static inline bool same_text(const char *stored,const char *text,const size_t len,const bool case_sensitive)
+{
+    if (case_sensitive) {
+        return memcmp(stored,text,len) == 0;
+    }
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(text);
+
+    for (size_t i=0; i<len; ++i) {
+        if (static_cast<unsigned char>(stored[i]) != lower_ascii(p[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Each shard is a complete table. The shard is picked with the top bits
+// of the hash and the slot with the low bits, so both stay well spread.
+struct LexemeTable::shard {
+    struct slot {
+        const char   *text;
+        unsigned int  hash;
+        unsigned int  len;
+    };
+
+    mutex   lock;
+    slot   *slots;
+    size_t  mask;
+    size_t  count;
+    Arena   strings;
+
+    shard():slots(static_cast<slot*>(calloc(initial_slots,sizeof(slot)))),mask(initial_slots-1),count(0) {}
+    ~shard() {free(slots);}
+
+    const char *get(const char *text,const size_t len,const bool case_sensitive,const unsigned int h,const bool copy=true);
+    void        grow();
+};
+
+static const unsigned concurrent_shards = 64;
+
+LexemeTable::LexemeTable(const bool concurrent):
+    _shards(new shard[concurrent ? concurrent_shards : 1]),_nshards(concurrent ? concurrent_shards : 1)
 {
 }
 
 LexemeTable::~LexemeTable()
 {
+    delete [] _shards;
 }
 
 const char *LexemeTable::get(const char *text,const bool case_sensitive)
 {
-    string stext = text;
+    return get(text,strlen(text),case_sensitive);
+}
+
+const char *LexemeTable::get(const char *text,const size_t len,const bool case_sensitive)
+{
+    const unsigned int h = hash_text(text,len,case_sensitive);
 
-    if (!case_sensitive) {
-        transform(stext.begin(),stext.end(),stext.begin(),::tolower);
+    if (_nshards == 1) {
+        return _shards->get(text,len,case_sensitive,h);
     }
-    set<string>::const_iterator p = _text.find(stext);
+    shard              &s = _shards[h >> 26 & (_nshards - 1)];
+    lock_guard<mutex>   g(s.lock);
 
-    if (p == _text.end()) {
-        _text.insert(stext);
-        p = _text.find(stext);
+    return s.get(text,len,case_sensitive,h);
+}
+
+const char *LexemeTable::adopt(const char *text,const size_t len)
+{
+    const unsigned int h = hash_text(text,len,true);
+
+    if (_nshards == 1) {
+        return _shards->get(text,len,true,h,false);
     }
-    return p->c_str();
+    shard              &s = _shards[h >> 26 & (_nshards - 1)];
+    lock_guard<mutex>   g(s.lock);
+
+    return s.get(text,len,true,h,false);
+}
+
+const char *LexemeTable::shard::get(const char *text,const size_t len,const bool case_sensitive,const unsigned int h,const bool copy)
+{
+    size_t i = h & mask;
+
+    while (slots[i].text) {
+        const slot &s = slots[i];
+
+        if (s.hash == h && s.len == len && same_text(s.text,text,len,case_sensitive)) {
+            return s.text;
+        }
+        i = (i + 1) & mask;
+    }
+
+    // Miss: store the (folded) text in the arena and claim the empty slot
+    const char *stored = text;
+
+    if (copy) {
+        char *c = strings.copy(text,len);
+
+        if (!case_sensitive) {
+            for (size_t x=0; x<len; ++x) {
+                c[x] = lower_ascii(c[x]);
+            }
+        }
+        stored = c;
+    }
+    slots[i].text = stored;
+    slots[i].hash = h;
+    slots[i].len  = static_cast<unsigned int>(len);
+
+    if (++count * 10 > (mask + 1) * 7) {
+        grow();
+    }
+    return stored;
+}
+
+void LexemeTable::shard::grow()
+{
+    const size_t newsize  = (mask + 1) * 2;
+    slot        *newslots = static_cast<slot*>(calloc(newsize,sizeof(slot)));
+
+    for (size_t x=0; x<=mask; ++x) {
+        if (slots[x].text) {
+            size_t i = slots[x].hash & (newsize - 1);
+
+            while (newslots[i].text) {
+                i = (i + 1) & (newsize - 1);
+            }
+            newslots[i] = slots[x];
+        }
+    }
+    free(slots);
+    slots = newslots;
+    mask  = newsize - 1;
+}
+
+size_t LexemeTable::size() const
+{
+    size_t n = 0;
+
+    for (unsigned x=0; x<_nshards; ++x) {
+        lock_guard<mutex> g(_shards[x].lock);
+        n += _shards[x].count;
+    }
+    return n;
+}
+
+static bool text_less(const char *a,const char *b)
+{
+    return strcmp(a,b) < 0;
 }
 
 void LexemeTable::print() const
 {
-    for (set<string>::const_iterator x=_text.begin(); x!=_text.end(); ++x) {
-        printf("%8p \"%s\"\n",x->c_str(),x->c_str());
+    vector<const char*> v;
+
+    for (unsigned s=0; s<_nshards; ++s) {
+        lock_guard<mutex> g(_shards[s].lock);
+
+        for (size_t x=0; x<=_shards[s].mask; ++x) {
+            if (_shards[s].slots[x].text) {
+                v.push_back(_shards[s].slots[x].text);
+            }
+        }
+    }
+    sort(v.begin(),v.end(),text_less);
+    for (vector<const char*>::const_iterator x=v.begin(); x!=v.end(); ++x) {
+        printf("%8p \"%s\"\n",*x,*x);
     }
 }
 
 //#define LEXEME_TABLE_SELF_TEST
 #ifdef  LEXEME_TABLE_SELF_TEST
-#include <iostream.h>
+#include <iostream>
 
-int main() 
+int main()
 {
     LexemeTable lt;
-    
+
     cout << lt.get("Hello") << "\n";
     cout << lt.get("Bye") << "\n";
     cout << lt.get("Hello") << "\n";
     cout << lt.get("Bye") << "\n";
+    cout << (lt.get("HELLO",false) == lt.get("hello")) << "\n";
+    cout << (lt.get("Hello world",size_t(5)) == lt.get("Hello")) << "\n";
 
     lt.print();
 
@@ -0,0 +1,68 @@
+// Memory mapped file
+// Author: David Berthelot
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "MappedFile.hxx"
+
+MappedFile::MappedFile():
+    _data(0),_size(0),_mapped(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+// An anonymous zeroed region is reserved first and the file is mapped over
+// its beginning. The padding then reads as zero whether it falls in the
+// tail of the last file page or in the anonymous pages after it.
+bool MappedFile::open(const char *filename,const size_t padding)
+{
+    close();
+
+    const int fd = ::open(filename,O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd,&st) || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    const size_t page   = sysconf(_SC_PAGESIZE);
+    const size_t size   = st.st_size;
+    const size_t mapped = (size + padding + page - 1) / page * page;
+    void        *base   = mapped ? mmap(0,mapped,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0) : MAP_FAILED;
+
+    if (base == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+    if (size && mmap(base,size,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_FIXED,fd,0) == MAP_FAILED) {
+        munmap(base,mapped);
+        ::close(fd);
+        return false;
+    }
+    ::close(fd);
+    if (size) {
+        madvise(base,size,MADV_SEQUENTIAL);
+    }
+    _data   = static_cast<char*>(base);
+    _size   = size;
+    _mapped = mapped;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_data) {
+        munmap(_data,_mapped);
+    }
+    _data   = 0;
+    _size   = 0;
+    _mapped = 0;
+}
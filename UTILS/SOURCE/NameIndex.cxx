@@ -0,0 +1,106 @@
+// Name Index
+// Author: David Berthelot
+
+#include "TextHash.hxx"
+#include "NameIndex.hxx"
+
+// Open addressing with linear probing, kept at most 70% full like the
+// lexeme table.
+
+static const size_t initial_slots = 16;
+
+NameIndex::NameIndex(const bool case_sensitive):
+    _slots(initial_slots),_mask(initial_slots-1),_count(0),_case_sensitive(case_sensitive)
+{
+}
+
+bool NameIndex::same(const slot &s,const char *name,const size_t len) const
+{
+    if (s.len != len) {
+        return false;
+    }
+    if (_case_sensitive) {
+        return memcmp(s.text,name,len) == 0;
+    }
+    for (size_t x=0; x<len; ++x) {
+        if (lower_ascii(s.text[x]) != lower_ascii(name[x])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void NameIndex::reserve(const size_t n)
+{
+    size_t nslots = _mask + 1;
+
+    while (n * 10 > nslots * 7) {
+        nslots *= 2;
+    }
+    if (nslots != _mask + 1) {
+        grow(nslots);
+    }
+}
+
+unsigned NameIndex::insert(const char *name,const unsigned id)
+{
+    return insert(name,strlen(name),id);
+}
+
+unsigned NameIndex::insert(const char *name,const size_t len,const unsigned id)
+{
+    const unsigned int h = hash_text(name,len,_case_sensitive);
+    size_t             i = h & _mask;
+
+    while (_slots[i].text) {
+        const slot &s = _slots[i];
+
+        if (s.hash == h && same(s,name,len)) {
+            return s.id;
+        }
+        i = (i + 1) & _mask;
+    }
+    _slots[i].text = name;
+    _slots[i].hash = h;
+    _slots[i].len  = static_cast<unsigned int>(len);
+    _slots[i].id   = id;
+
+    if (++_count * 10 > (_mask + 1) * 7) {
+        grow((_mask + 1) * 2);
+    }
+    return id;
+}
+
+unsigned NameIndex::find(const char *name,const size_t len) const
+{
+    const unsigned int h = hash_text(name,len,_case_sensitive);
+    size_t             i = h & _mask;
+
+    while (_slots[i].text) {
+        const slot &s = _slots[i];
+
+        if (s.hash == h && same(s,name,len)) {
+            return s.id;
+        }
+        i = (i + 1) & _mask;
+    }
+    return npos;
+}
+
+void NameIndex::grow(const size_t nslots)
+{
+    vector<slot> newslots(nslots);
+
+    for (size_t x=0; x<=_mask; ++x) {
+        if (_slots[x].text) {
+            size_t i = _slots[x].hash & (nslots - 1);
+
+            while (newslots[i].text) {
+                i = (i + 1) & (nslots - 1);
+            }
+            newslots[i] = _slots[x];
+        }
+    }
+    _slots.swap(newslots);
+    _mask = nslots - 1;
+}
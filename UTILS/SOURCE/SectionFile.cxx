@@ -0,0 +1,174 @@
+// Sectioned binary file
+// Author: David Berthelot
+
+#include <stddef.h>
+#include <string.h>
+#include "SectionFile.hxx"
+
+struct section_header {
+    char      magic[8];
+    uint32_t  version;
+    uint32_t  order;
+    uint64_t  size;             // Of the whole file
+    uint32_t  sections;
+    uint32_t  extra;            // Size of the format's own header
+};
+
+static const uint32_t section_order = 0x01020304;
+
+static size_t align8(const size_t n)
+{
+    return (n + 7) & ~static_cast<size_t>(7);
+}
+
+// Size of the headers, the sections start after it
+static size_t header_size(const unsigned nsections,const size_t extra_size)
+{
+    return sizeof(section_header) + 2 * nsections * sizeof(uint64_t) + align8(extra_size);
+}
+
+
+//-----------------------------------------------------------------------------
+// Class SectionWriter
+//-----------------------------------------------------------------------------
+SectionWriter::SectionWriter():
+    _file(0),_written(0),_isok(false)
+{
+}
+
+SectionWriter::~SectionWriter()
+{
+    if (_file) {
+        fclose(_file);
+    }
+}
+
+uint32_t SectionWriter::add_string(const char *s)
+{
+    if (!s) {
+        return SectionFile::none;
+    }
+    const uint32_t id = _ids.insert(s,static_cast<unsigned>(_offsets.size()));
+
+    if (id == _offsets.size()) {
+        _offsets.push_back(static_cast<uint32_t>(_strings.size()));
+        _strings.insert(_strings.end(),s,s + strlen(s) + 1);
+    }
+    return id;
+}
+
+// The header is written again by close(), once the sections are placed
+bool SectionWriter::open(const char *path,const char magic[8],const uint32_t version,const unsigned nsections,
+                         const void *extra,const size_t extra_size)
+{
+    static const char pad[8] = {0};
+    section_header    h;
+
+    if (_file || nsections < SectionFile::FIRST_SECTION || extra_size > SectionFile::none ||
+        _strings.size() >= SectionFile::none || !(_file = fopen(path,"wb"))) {
+        return false;
+    }
+    memset(&h,0,sizeof(h));
+    memcpy(h.magic,magic,sizeof(h.magic));
+    h.version  = version;
+    h.order    = section_order;
+    h.sections = nsections;
+    h.extra    = static_cast<uint32_t>(extra_size);
+    _table.assign(2 * nsections,0);
+    _written   = 0;
+
+    _isok = fwrite(&h,sizeof(h),1,_file) == 1 && fwrite(_table.data(),sizeof(uint64_t),_table.size(),_file) == _table.size();
+    _isok = _isok && (!extra_size || fwrite(extra,1,extra_size,_file) == extra_size);
+    _isok = _isok && fwrite(pad,1,align8(extra_size) - extra_size,_file) == align8(extra_size) - extra_size;
+    _isok = _isok && write(_strings) && write(_offsets);
+    return _isok;
+}
+
+bool SectionWriter::write(const void *records,const size_t record_size,const size_t count)
+{
+    static const char pad[8] = {0};
+    const unsigned    nsections = static_cast<unsigned>(_table.size() / 2);
+
+    if (!_file || _written >= nsections) {
+        _isok = false;
+        return false;
+    }
+    const long   at    = ftell(_file);
+    const size_t align = align8(at) - at;
+
+    _table[_written]             = count;
+    _table[nsections + _written] = at + align;
+    ++_written;
+    _isok = _isok && at >= 0 && fwrite(pad,1,align,_file) == align && (!count || fwrite(records,record_size,count,_file) == count);
+    return _isok;
+}
+
+bool SectionWriter::close()
+{
+    if (!_file) {
+        return false;
+    }
+    const long     at   = ftell(_file);
+    const uint64_t size = at;
+
+    _isok = _isok && at >= 0 && _written == _table.size() / 2;
+    _isok = _isok && fseek(_file,offsetof(section_header,size),SEEK_SET) == 0 && fwrite(&size,sizeof(size),1,_file) == 1;
+    _isok = _isok && fseek(_file,sizeof(section_header),SEEK_SET) == 0 &&
+                     fwrite(_table.data(),sizeof(uint64_t),_table.size(),_file) == _table.size();
+    _isok = (fclose(_file) == 0) && _isok;
+    _file = 0;
+    return _isok;
+}
+
+
+//-----------------------------------------------------------------------------
+// Class SectionReader
+//-----------------------------------------------------------------------------
+SectionReader::SectionReader():
+    _count(0),_offset(0),_extra(0),_strings(0),_isok(false)
+{
+}
+
+SectionReader::T_Status SectionReader::open(const char *path,const char magic[8],const uint32_t version,const unsigned nsections,
+                                            const size_t *record_size,const size_t extra_size)
+{
+    _isok = false;
+    if (!_file.open(path)) {
+        return R_MISSING;
+    }
+    const section_header *h    = reinterpret_cast<const section_header*>(_file.data());
+    const size_t          size = _file.size();
+
+    if (size < sizeof(section_header) || memcmp(h->magic,magic,sizeof(h->magic)) || h->version != version ||
+        h->order != section_order) {
+        return R_FOREIGN;
+    }
+    if (h->size != size || h->sections != nsections || h->extra != extra_size || size < header_size(nsections,extra_size)) {
+        return R_CORRUPTED;
+    }
+    _count  = reinterpret_cast<const uint64_t*>(_file.data() + sizeof(section_header));
+    _offset = _count + nsections;
+    _extra  = _offset + nsections;
+    for (unsigned s=0; s<nsections; ++s) {
+        const size_t rs = s == SectionFile::STRINGS ? 1 : s == SectionFile::OFFSETS ? sizeof(uint32_t) : record_size[s - SectionFile::FIRST_SECTION];
+
+        if (_offset[s] % 8 || _offset[s] > size || _count[s] > (size - _offset[s]) / rs) {
+            return R_CORRUPTED;
+        }
+    }
+
+    // Every string ends within the pool
+    const size_t pool = _count[SectionFile::STRINGS];
+
+    _strings = section<uint32_t>(SectionFile::OFFSETS);
+    if (pool >= SectionFile::none || (pool && get_string_pool()[pool - 1])) {
+        return R_CORRUPTED;
+    }
+    for (size_t x=0; x<get_string_count(); ++x) {
+        if (_strings[x] >= pool) {
+            return R_CORRUPTED;
+        }
+    }
+    _isok = true;
+    return R_OK;
+}
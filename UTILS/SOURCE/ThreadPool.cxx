@@ -0,0 +1,152 @@
+// Thread Pool
+// Author: David Berthelot
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ThreadPool.hxx"
+
+static thread_local bool in_pool = false;
+
+struct ThreadPool::data {
+    mutex                              lock;
+    mutex                              busy;     // Held by the thread issuing run()
+    condition_variable                 wake;
+    condition_variable                 done;
+    vector<thread>                     workers;
+    const function<void(size_t)>      *task;     // Of the current run(), 0 between runs
+    size_t                             ntasks;
+    atomic<size_t>                     next;
+    size_t                             pending;  // Tasks not finished yet
+    unsigned                           active;   // Workers inside drain()
+    unsigned                           generation;
+    bool                               stop;
+
+    data():task(0),ntasks(0),next(0),pending(0),active(0),generation(0),stop(false) {}
+
+    void work();
+    void drain(const function<void(size_t)> *t,const size_t n);
+};
+
+// Takes tasks until there are none left. The task and its count are read
+// under the lock by the caller: the members change with the next run()
+void ThreadPool::data::drain(const function<void(size_t)> *t,const size_t n)
+{
+    size_t finished = 0;
+
+    for (size_t x = next++; x < n; x = next++) {
+        (*t)(x);
+        ++finished;
+    }
+    if (finished) {
+        lock_guard<mutex> g(lock);
+
+        pending -= finished;
+        if (!pending && !active) {
+            done.notify_all();
+        }
+    }
+}
+
+void ThreadPool::data::work()
+{
+    unsigned seen = 0;
+
+    in_pool = true;
+    for (;;) {
+        const function<void(size_t)> *t;
+        size_t                        n;
+        {
+            unique_lock<mutex> g(lock);
+
+            while (!stop && generation == seen) {
+                wake.wait(g);
+            }
+            if (stop) {
+                return;
+            }
+            seen = generation;
+            // Woken too late, the run() is over
+            if (!task) {
+                continue;
+            }
+            t = task;
+            n = ntasks;
+            active++;
+        }
+        drain(t,n);
+
+        lock_guard<mutex> g(lock);
+        if (!--active && !pending) {
+            done.notify_all();
+        }
+    }
+}
+
+ThreadPool::ThreadPool(const unsigned nthreads):
+    _data(new data())
+{
+    const unsigned n = nthreads ? nthreads : thread::hardware_concurrency();
+
+    // The thread calling run() takes its share, so spawn one worker less
+    for (unsigned x=1; x<n; ++x) {
+        _data->workers.push_back(thread(&data::work,_data));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> g(_data->lock);
+        _data->stop = true;
+    }
+    _data->wake.notify_all();
+    for (size_t x=0; x<_data->workers.size(); ++x) {
+        _data->workers[x].join();
+    }
+    delete _data;
+}
+
+unsigned ThreadPool::size() const
+{
+    return _data->workers.size() + 1;
+}
+
+void ThreadPool::run(const size_t ntasks,const function<void(size_t)> &task)
+{
+    unique_lock<mutex> busy(_data->busy,defer_lock);
+
+    if (in_pool || _data->workers.empty() || ntasks < 2 || !busy.try_lock()) {
+        for (size_t x=0; x<ntasks; ++x) {
+            task(x);
+        }
+        return;
+    }
+    {
+        unique_lock<mutex> g(_data->lock);
+
+        // No worker of the previous run() may still be taking its indices
+        while (_data->active) {
+            _data->done.wait(g);
+        }
+        _data->task    = &task;
+        _data->ntasks  = ntasks;
+        _data->next    = 0;
+        _data->pending = ntasks;
+        _data->generation++;
+    }
+    _data->wake.notify_all();
+
+    in_pool = true;
+    _data->drain(&task,ntasks);
+    in_pool = false;
+
+    unique_lock<mutex> g(_data->lock);
+    // Also wait for late workers to leave drain() before the task goes away
+    while (_data->pending || _data->active) {
+        _data->done.wait(g);
+    }
+    _data->task = 0;
+}